@@ -0,0 +1,300 @@
+#include <Arduino.h>
+#include <avr/eeprom.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.hpp"
+#include "crc16X25.hpp"
+#include "eepromWriter.hpp"
+#include "uart.hpp"
+#include "debug.hpp"
+
+
+enum
+{
+    eCONFIG_LAYOUT = 2,         // has to be incremented whenever config_t changes, so an old record is not misinterpreted
+
+    eCONFIG_SLOT_SIZE = 32,     // EEPROM bytes per record
+    eCONFIG_SLOTS     = 16,     // records in the ring, each commit writes the next one, so each slot is written once per eCONFIG_SLOTS commits
+};
+
+// EEPROM record of the configuration, the CRC covers everything in front of it, the record with the latest sequence number and a
+// valid CRC is the active one, an interrupted write only damages the new record, so the previous one stays valid
+typedef struct
+{
+    uint16_t sequence;
+    uint8_t  layout;
+    config_t config;
+    uint16_t crc;
+} configRecord_t;
+
+static_assert(sizeof(configRecord_t) <= eCONFIG_SLOT_SIZE, "configuration record doesn't fit into a slot");
+
+static uint8_t EEMEM configRing[eCONFIG_SLOTS][eCONFIG_SLOT_SIZE];
+
+// parameter limits and defaults
+typedef struct
+{
+    uint16_t minimum;
+    uint16_t maximum;
+    uint16_t defaultValue;
+} parameterLimits_t;
+
+static const parameterLimits_t parameterLimits[eCONFIG_PARAMETERS] =
+{
+    { 1000,  60000, 60000 },                                                // eCONFIG_WATCHDOG_TIME
+    { 10000, 60000, 30000 },                                                // eCONFIG_RESET_LOCK_TIME, long enough for the battery switch off circuit
+    { 1000,  60000, 10000 },                                                // eCONFIG_TEST_TIMEOUT_TIME
+    { 1,     6000,  6000 },                                                 // eCONFIG_TEST_REPEAT_TIME, at least each 100h
+    { 50,    10000, 2000 },                                                 // eCONFIG_LED_SLOW_TIME
+    { 50,    10000, 100 },                                                  // eCONFIG_LED_FAST_TIME
+    { 96,    10000, eUART_BAUD_RATE_DEFAULT / eUART_BAUD_RATE_UNIT },       // eCONFIG_BAUD_RATE
+};
+
+static config_t active;         // active configuration
+static config_t staged;         // configuration to be committed
+static uint16_t sequence;       // sequence number of the active record
+static uint8_t  slot;           // slot of the active record
+static bool     stored;         // active configuration has been read from or written to EEPROM (otherwise defaults are used)
+
+static configRecord_t writeRecord;          // record written in the background, it stays unchanged until the write is over
+
+
+// CRC of a configuration record without its CRC field
+static uint16_t recordCrc(const configRecord_t *record)
+{
+    const uint8_t *data = (const uint8_t *)record;
+    uint16_t crc = eCRC16_X25_INIT;
+    for (uint8_t index = 0; index < offsetof(configRecord_t, crc); index++)
+    {
+        crc = crc16X25Step(data[index], crc);
+    }
+    return crc16X25Xor(crc);
+}
+
+
+// configuration values have to be in range, otherwise an output could be pulsed too slowly to be safe
+static bool configValid(const config_t *candidate)
+{
+    bool valid = !(candidate->pulsedOutputs & ~eALL_OUTPUTS_MASK);
+    for (uint8_t index = 0; index < eSUPPORTED_OUTPUTS; index++)
+    {
+        valid = valid && candidate->pulsePeriods[index] && (candidate->pulsePeriods[index] <= eMAX_PULSE_PERIOD);
+    }
+    for (uint8_t index = 0; index < eCONFIG_PARAMETERS; index++)
+    {
+        valid = valid && (candidate->parameters[index] >= parameterLimits[index].minimum) &&
+                         (candidate->parameters[index] <= parameterLimits[index].maximum);
+    }
+    return valid;
+}
+
+
+/**
+ * @brief Load the latest valid configuration record from EEPROM, defaults are used if there is none, has to be called before
+ *        ioHandler_setup() and uart_setup()
+ */
+void config_setup(void)
+{
+    bool found = false;
+    for (uint8_t index = 0; index < eCONFIG_SLOTS; index++)
+    {
+        configRecord_t record;
+        eeprom_read_block(&record, configRing[index], sizeof(record));
+        if ((record.layout == eCONFIG_LAYOUT) && (record.crc == recordCrc(&record)) && configValid(&record.config) &&
+            (!found || ((int16_t)(record.sequence - sequence) > 0)))
+        {
+            found    = true;
+            active   = record.config;
+            sequence = record.sequence;
+            slot     = index;
+        }
+    }
+
+    if (!found)
+    {
+        active.pulsedOutputs = ePULSED_OUTPUTS_DEFAULT;
+        for (uint8_t index = 0; index < eSUPPORTED_OUTPUTS; index++)
+        {
+            active.pulsePeriods[index] = ePULSE_PERIOD_DEFAULT;
+        }
+        for (uint8_t index = 0; index < eCONFIG_PARAMETERS; index++)
+        {
+            active.parameters[index] = parameterLimits[index].defaultValue;
+        }
+        sequence = 0;
+        slot     = eCONFIG_SLOTS - 1;       // first record is written to slot 0
+    }
+    stored = found;
+    staged = active;
+}
+
+
+/**
+ * @brief Get the active configuration
+ *
+ * @return configuration loaded at startup or written afterwards
+ */
+const config_t *config_get(void)
+{
+    return &active;
+}
+
+
+/**
+ * @brief Get an active configuration parameter
+ *
+ * @param parameter     eCONFIG_...
+ *
+ * @return parameter value, 0 for unknown parameters
+ */
+uint16_t config_getParameter(uint8_t parameter)
+{
+    return (parameter < eCONFIG_PARAMETERS) ? active.parameters[parameter] : 0;
+}
+
+
+/**
+ * @brief Check if the active configuration is stored in EEPROM
+ *
+ * @return false if the defaults are used or the active configuration is still being written
+ */
+bool config_stored(void)
+{
+    return stored && !config_writing();
+}
+
+
+/**
+ * @brief Check if a configuration record is being written
+ *
+ * @return true until the EEPROM writer has written the last byte
+ */
+bool config_writing(void)
+{
+    return eepromWriter_pending(&writeRecord);
+}
+
+
+/**
+ * @brief Make a configuration the active and the staged one and write it to the next slot of the EEPROM ring, the write is done by
+ *        the EEPROM writer in the background
+ *
+ * @param newConfig     configuration to be stored
+ *
+ * @return true if the configuration is valid and the write has been started, false if it's invalid or a write is still running
+ */
+bool config_write(const config_t *newConfig)
+{
+    bool result = false;
+    if (!config_writing() && configValid(newConfig))
+    {
+        uint8_t nextSlot = (slot + 1) % eCONFIG_SLOTS;
+        writeRecord.sequence = sequence + 1;
+        writeRecord.layout   = eCONFIG_LAYOUT;
+        writeRecord.config   = *newConfig;
+        writeRecord.crc      = recordCrc(&writeRecord);
+        if (eepromWriter_write((uintptr_t)configRing[nextSlot], &writeRecord, sizeof(writeRecord)))
+        {
+            noInterrupts();
+            active = *newConfig;
+            interrupts();
+            staged   = *newConfig;
+            slot     = nextSlot;
+            sequence = writeRecord.sequence;
+            stored   = true;
+            result   = true;
+        }
+    }
+    return result;
+}
+
+
+/**
+ * @brief Check if a value is within the limits of a parameter
+ *
+ * @param parameter     eCONFIG_...
+ * @param value         value to be checked
+ *
+ * @return true if the parameter is known and the value is within its limits
+ */
+bool config_parameterValid(uint8_t parameter, uint16_t value)
+{
+    return (parameter < eCONFIG_PARAMETERS) && (value >= parameterLimits[parameter].minimum) && (value <= parameterLimits[parameter].maximum);
+}
+
+
+/**
+ * @brief Change a parameter of the staged configuration, it becomes active with config_commit()
+ *
+ * @param parameter     eCONFIG_...
+ * @param value         new value, has to be within the parameter limits
+ *
+ * @return true if the parameter has been staged
+ */
+bool config_stageParameter(uint8_t parameter, uint16_t value)
+{
+    bool result = false;
+    if (config_parameterValid(parameter, value))
+    {
+        staged.parameters[parameter] = value;
+        result = true;
+    }
+    return result;
+}
+
+
+/**
+ * @brief Get a staged configuration parameter
+ *
+ * @param parameter     eCONFIG_...
+ *
+ * @return parameter value, 0 for unknown parameters
+ */
+uint16_t config_getStagedParameter(uint8_t parameter)
+{
+    return (parameter < eCONFIG_PARAMETERS) ? staged.parameters[parameter] : 0;
+}
+
+
+/**
+ * @brief Check if staged parameters differ from the active ones
+ *
+ * @return true if there is something to commit
+ */
+bool config_staged(void)
+{
+    return memcmp(&staged, &active, sizeof(staged)) != 0;
+}
+
+
+/**
+ * @brief Make the staged configuration the active one and write it to EEPROM
+ *
+ * @return false if a write is still running
+ */
+bool config_commit(void)
+{
+    return config_write(&staged);
+}
+
+
+/**
+ * @brief Throw away all staged parameters
+ */
+void config_discard(void)
+{
+    staged = active;
+}
+
+
+/**
+ * @brief Get the sequence number of the active configuration record
+ *
+ * @return sequence number (incremented with each commit), 0 if the defaults are used
+ */
+uint16_t config_getSequence(void)
+{
+    return sequence;
+}
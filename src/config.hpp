@@ -0,0 +1,50 @@
+#if not defined CONFIG_H
+#define CONFIG_H
+
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ioHandler.hpp"
+
+
+// configuration parameters that can be read, staged and committed by parameter number
+enum
+{
+    eCONFIG_WATCHDOG_TIME,          // ms until the watchdog has to be triggered again
+    eCONFIG_RESET_LOCK_TIME,        // ms the reset port stays locked after a watchdog error
+    eCONFIG_TEST_TIMEOUT_TIME,      // ms until the readback has to show the expected state during a self test
+    eCONFIG_TEST_REPEAT_TIME,       // minutes between two self tests
+    eCONFIG_LED_SLOW_TIME,          // ms between two LED toggles while the watchdog is running
+    eCONFIG_LED_FAST_TIME,          // ms between two LED toggles in watchdog error state
+    eCONFIG_BAUD_RATE,              // baud rate after startup and fallback baud rate in eUART_BAUD_RATE_UNIT steps
+
+    eCONFIG_PARAMETERS,
+};
+
+
+// board configuration, stored CRC protected in EEPROM so a single firmware serves all board variants
+typedef struct
+{
+    uint8_t  pulsedOutputs;                         // bit mask of pulsed outputs, bit 0 is output 0
+    uint8_t  pulsePeriods[eSUPPORTED_OUTPUTS];      // ticks between two toggles of a pulsed output
+    uint16_t parameters[eCONFIG_PARAMETERS];        // see eCONFIG_...
+} config_t;
+
+
+void config_setup(void);
+const config_t *config_get(void);
+uint16_t config_getParameter(uint8_t parameter);
+bool config_stored(void);
+bool config_writing(void);
+bool config_write(const config_t *config);
+
+bool config_parameterValid(uint8_t parameter, uint16_t value);
+bool config_stageParameter(uint8_t parameter, uint16_t value);
+uint16_t config_getStagedParameter(uint8_t parameter);
+bool config_staged(void);
+bool config_commit(void);
+void config_discard(void);
+uint16_t config_getSequence(void);
+
+
+#endif
@@ -1,10 +1,12 @@
 #include <stdint.h>
 #include <stdio.h>
+#include <avr/pgmspace.h>
 #include "crc16X25.hpp"
 #include "debug.hpp"
 
 
-static uint16_t CRC16_X25_TABLE[] =
+// table is kept in flash to save 512 bytes of RAM
+static const uint16_t CRC16_X25_TABLE[] PROGMEM =
 {
     0x0000, 0x1189, 0x2312, 0x329B, 0x4624, 0x57AD, 0x6536, 0x74BF,
     0x8C48, 0x9DC1, 0xAF5A, 0xBED3, 0xCA6C, 0xDBE5, 0xE97E, 0xF8F7,
@@ -43,7 +45,7 @@ static uint16_t CRC16_X25_TABLE[] =
 
 uint16_t crc16X25Step(char data, uint16_t crcSum)
 {
-    return CRC16_X25_TABLE[(uint8_t)(data ^ crcSum)] ^ (uint8_t)(crcSum >> 8);
+    return pgm_read_word(&CRC16_X25_TABLE[(uint8_t)(data ^ crcSum)]) ^ (uint8_t)(crcSum >> 8);
 }
 
 
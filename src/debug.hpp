@@ -4,6 +4,7 @@
 
 #include <Arduino.h>
 #include <pins_arduino.h>
+#include "uart.hpp"
 
 
 //#define DEBUG              // firmware "D_xxx"
@@ -35,21 +36,21 @@ extern char debugPrintBuffer[100];
 
 
 #   if defined DEBUG1
-#       define P1(...) do { sprintf(debugPrintBuffer, __VA_ARGS__); Serial.print(debugPrintBuffer); } while (0)
+#       define P1(...) do { sprintf(debugPrintBuffer, __VA_ARGS__); uart_print(debugPrintBuffer); } while (0)
 #   else
 #       define P1(...)
 #   endif
 
 
 #   if defined DEBUG2
-#       define P2(...) do { sprintf(debugPrintBuffer, __VA_ARGS__); Serial.print(debugPrintBuffer); } while (0)
+#       define P2(...) do { sprintf(debugPrintBuffer, __VA_ARGS__); uart_print(debugPrintBuffer); } while (0)
 #   else
 #       define P2(...)
 #   endif
 
 
 #   if defined DEBUG3
-#       define P3(...) do { sprintf(debugPrintBuffer, __VA_ARGS__); Serial.print(debugPrintBuffer); } while (0)
+#       define P3(...) do { sprintf(debugPrintBuffer, __VA_ARGS__); uart_print(debugPrintBuffer); } while (0)
 #   else
 #       define P3(...)
 #   endif
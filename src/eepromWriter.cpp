@@ -0,0 +1,144 @@
+#include <Arduino.h>
+#include <util/atomic.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "eepromWriter.hpp"
+#include "debug.hpp"
+
+
+// queued write, the data has to stay unchanged until eepromWriter_pending() returns false
+typedef struct
+{
+    uint16_t       address;
+    const uint8_t *data;
+    uint8_t        length;
+} eepromJob_t;
+
+static_assert(!(eEEPROM_WRITER_JOBS & (eEEPROM_WRITER_JOBS - 1)), "eEEPROM_WRITER_JOBS has to be a power of two");
+static eepromJob_t      jobs[eEEPROM_WRITER_JOBS];
+static volatile uint8_t jobHead;            // next job to be queued
+static volatile uint8_t jobTail;            // job being written
+static volatile uint8_t jobPosition;        // next byte of the job being written
+
+
+// write the next changed byte of the queued jobs, one byte per interrupt since each byte takes ~3.3ms, unchanged bytes are
+// skipped to save time and wear
+ISR(EE_READY_vect)
+{
+    while (jobTail != jobHead)
+    {
+        const eepromJob_t *job = &jobs[jobTail & (eEEPROM_WRITER_JOBS - 1)];
+        while (jobPosition < job->length)
+        {
+            uint8_t data = job->data[jobPosition];
+            EEAR = job->address + jobPosition++;
+            EECR |= (1 << EERE);
+            if (EEDR != data)
+            {
+                EEDR = data;
+                EECR |= (1 << EEMPE);       // EEPE has to be set within 4 cycles
+                EECR |= (1 << EEPE);
+                return;
+            }
+        }
+
+        // job written completely
+        jobTail++;
+        jobPosition = 0;
+    }
+
+    // all jobs written
+    EECR &= ~(1 << EERIE);
+}
+
+
+/**
+ * @brief Queue an EEPROM write that is done by the EEPROM ready interrupt in the background, can be called from interrupts as well
+ *
+ * @param address   EEPROM address
+ * @param data      data to be written, has to stay unchanged until eepromWriter_pending() returns false
+ * @param length    number of bytes
+ *
+ * @return false if the queue is full
+ */
+bool eepromWriter_write(uint16_t address, const void *data, uint8_t length)
+{
+    bool result = false;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if ((uint8_t)(jobHead - jobTail) < eEEPROM_WRITER_JOBS)
+        {
+            eepromJob_t *job = &jobs[jobHead & (eEEPROM_WRITER_JOBS - 1)];
+            job->address = address;
+            job->data    = (const uint8_t *)data;
+            job->length  = length;
+            jobHead++;
+            EECR |= (1 << EERIE);           // interrupt occurs as soon as the EEPROM is ready
+            result = true;
+        }
+    }
+    return result;
+}
+
+
+/**
+ * @brief Check if a write of the given data is still queued
+ *
+ * @param data      data given to eepromWriter_write()
+ *
+ * @return true until the write has been done
+ */
+bool eepromWriter_pending(const void *data)
+{
+    bool pending = false;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        for (uint8_t index = jobTail; index != jobHead; index++)
+        {
+            pending |= (jobs[index & (eEEPROM_WRITER_JOBS - 1)].data == data);
+        }
+    }
+    return pending;
+}
+
+
+/**
+ * @brief Read from EEPROM while writes may be running in the background, only a byte write in progress delays the read (the queued
+ * ones continue afterwards) and interrupts are only disabled for a single byte
+ *
+ * @param data      buffer
+ * @param address   EEPROM address
+ * @param length    number of bytes
+ */
+void eepromWriter_read(void *data, uint16_t address, uint8_t length)
+{
+    uint8_t *buffer = (uint8_t *)data;
+    for (uint8_t index = 0; index < length; )
+    {
+        // the EEPROM ready interrupt would start the next queued byte as soon as the running one is done, so it's held off while
+        // waiting (again for each byte since eepromWriter_write() called by an ISR enables it)
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            EECR &= ~(1 << EERIE);
+        }
+        while (EECR & (1 << EEPE));
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            if (!(EECR & (1 << EEPE)))
+            {
+                EEAR = address + index;
+                EECR |= (1 << EERE);
+                buffer[index++] = EEDR;
+            }
+        }
+    }
+
+    // continue with the queued writes
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (jobTail != jobHead)
+        {
+            EECR |= (1 << EERIE);
+        }
+    }
+}
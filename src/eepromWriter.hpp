@@ -0,0 +1,20 @@
+#if not defined EEPROM_WRITER_H
+#define EEPROM_WRITER_H
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+enum
+{
+    eEEPROM_WRITER_JOBS = 8,        // writes that can be queued, has to be a power of two
+};
+
+
+bool eepromWriter_write(uint16_t address, const void *data, uint8_t length);
+bool eepromWriter_pending(const void *data);
+void eepromWriter_read(void *data, uint16_t address, uint8_t length);
+
+
+#endif
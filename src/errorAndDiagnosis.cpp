@@ -1,19 +1,76 @@
+#include <Arduino.h>
+#include <util/atomic.h>
 #include "errorAndDiagnosis.hpp"
+#include "history.hpp"
+#include "timer.hpp"
 
 
+enum
+{
+    eLOGGED_ERRORS = 4,     // errors whose last history entry is remembered for the rate limit
+};
+
+static const uint32_t errorLogInterval = 60000UL / eTICK_TIME;     // ticks until the same error is logged again
+
+typedef struct
+{
+    uint16_t error;
+    uint32_t loggedTicks;   // tick counter when the error has been logged
+} loggedError_t;
+
 static uint16_t errorNumber = eERROR_NONE;
 static uint16_t diagnoses   = eDIAGNOSIS_INIT;
 static uint16_t executedTests = eEXECUTED_TEST_NONE;
+static loggedError_t loggedErrors[eLOGGED_ERRORS];     // a recurring error is logged once per interval only, so it can't flush the history
+
+
+// check if an error has to be logged (it hasn't been logged within the interval) and remember it, the least recently logged error
+// is replaced if it's a new one
+static bool errorLogDue(uint16_t error)
+{
+    bool due = true;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        uint32_t ticks = timer_getTicks();
+        loggedError_t *slot = &loggedErrors[0];
+        for (uint8_t index = 0; index < eLOGGED_ERRORS; index++)
+        {
+            loggedError_t *loggedError = &loggedErrors[index];
+            if (loggedError->error == error)
+            {
+                slot = loggedError;
+                due  = (ticks - loggedError->loggedTicks >= errorLogInterval);
+                break;
+            }
+            else if (ticks - loggedError->loggedTicks > ticks - slot->loggedTicks)
+            {
+                slot = loggedError;
+            }
+        }
+        if (due)
+        {
+            slot->error       = error;
+            slot->loggedTicks = ticks;
+        }
+    }
+    return due;
+}
 
 
 /**
  * @brief Sets new error value if there is none stored currently (only first error will be stored since usually that's the important one!)
- * A getErrorNumber() call clears the last error again and a new one can be stored
+ * A getErrorNumber() call clears the last error again and a new one can be stored, each error is logged in the history but a
+ * recurring one only once per errorLogInterval
  *
  * @param newError          error number to be set if there is none stored so far
  */
 void errorAndDiagnosis_setError(uint16_t newError)
 {
+    if (errorLogDue(newError))
+    {
+        history_log(eHISTORY_ERROR, newError);
+    }
+
     // only remember first error since that's the most important one
     if (errorNumber == eERROR_NONE)
     {
@@ -84,3 +141,15 @@ uint16_t errorAndDiagnosis_getExecutedTests(void)
     return executedTestsTemp;
 }
 
+
+
+/**
+ * @brief To check if there is anything that hasn't been read so far
+ *
+ * @return true     error, diagnoses or executed tests are pending
+ * @return false    nothing to be read
+ */
+bool errorAndDiagnosis_pending(void)
+{
+    return (errorNumber != eERROR_NONE) || (diagnoses != eDIAGNOSIS_NONE) || (executedTests != eEXECUTED_TEST_NONE);
+}
@@ -28,7 +28,7 @@ enum
 
     eDIAGNOSIS_STARTUP = 1 << 0,
 
-    eDIAGNOSIS_RESERVED1 = 1 << 1,
+    eDIAGNOSIS_LOW_STACK = 1 << 1,      // less than eSTACK_LOW_THRESHOLD bytes have been left between heap and stack
     eDIAGNOSIS_RESERVED2 = 1 << 2,
     eDIAGNOSIS_RESERVED3 = 1 << 3,
     eDIAGNOSIS_RESERVED4 = 1 << 4,
@@ -78,6 +78,7 @@ void     errorAndDiagnosis_setExecutedTest(uint16_t executedTest);
 uint16_t errorAndDiagnosis_getErrorNumber(void);
 uint16_t errorAndDiagnosis_getDiagnoses(void);
 uint16_t errorAndDiagnosis_getExecutedTests(void);
+bool     errorAndDiagnosis_pending(void);
 
 
 #endif
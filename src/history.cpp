@@ -0,0 +1,162 @@
+#include <Arduino.h>
+#include <avr/eeprom.h>
+#include <util/atomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "history.hpp"
+#include "eepromWriter.hpp"
+#include "crc16X25.hpp"
+#include "timer.hpp"
+#include "debug.hpp"
+
+
+enum
+{
+    ePENDING_ENTRIES = 8,           // entries waiting for the EEPROM writer, has to be a power of two
+};
+
+static_assert(!(eHISTORY_ENTRIES & (eHISTORY_ENTRIES - 1)), "eHISTORY_ENTRIES has to be a power of two");
+static_assert(!(ePENDING_ENTRIES & (ePENDING_ENTRIES - 1)), "ePENDING_ENTRIES has to be a power of two");
+
+static historyEntry_t EEMEM historyRing[eHISTORY_ENTRIES];
+
+static historyEntry_t pendingEntries[ePENDING_ENTRIES];     // entries are written from here, index is the lower bits of the sequence number
+static uint16_t nextSequence;                               // sequence number of the next entry
+static uint16_t boot;                                       // boot counter of this startup
+static uint16_t lostEntries;                                // entries not logged because the EEPROM writer was too slow
+
+
+// CRC of a history entry without its CRC field
+static uint16_t entryCrc(const historyEntry_t *entry)
+{
+    const uint8_t *data = (const uint8_t *)entry;
+    uint16_t crc = eCRC16_X25_INIT;
+    for (uint8_t index = 0; index < offsetof(historyEntry_t, crc); index++)
+    {
+        crc = crc16X25Step(data[index], crc);
+    }
+    return crc16X25Xor(crc);
+}
+
+
+/**
+ * @brief Find the latest history entry to continue the sequence and the boot counter and log the startup, has to be called
+ *        before any other history function
+ */
+void history_setup(void)
+{
+    bool found = false;
+    for (uint8_t index = 0; index < eHISTORY_ENTRIES; index++)
+    {
+        historyEntry_t entry;
+        eeprom_read_block(&entry, &historyRing[index], sizeof(entry));
+        if ((entry.crc == entryCrc(&entry)) && ((entry.sequence & (eHISTORY_ENTRIES - 1)) == index) &&
+            (!found || ((int16_t)(entry.sequence - nextSequence) >= 0)))
+        {
+            found        = true;
+            nextSequence = entry.sequence + 1;
+            boot         = entry.boot + 1;
+        }
+    }
+
+    history_log(eHISTORY_STARTUP, 0);
+}
+
+
+/**
+ * @brief Append an entry to the history, the EEPROM write is done in the background, can be called from interrupts as well
+ *
+ * @param type      eHISTORY_...
+ * @param code      error number, watchdog state, ...
+ */
+void history_log(uint8_t type, uint16_t code)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        historyEntry_t *entry = &pendingEntries[nextSequence & (ePENDING_ENTRIES - 1)];
+        if (eepromWriter_pending(entry))
+        {
+            lostEntries++;      // entry that was logged ePENDING_ENTRIES entries ago hasn't been written so far
+        }
+        else
+        {
+            entry->sequence = nextSequence;
+            entry->boot     = boot;
+            entry->ticks    = timer_getTicks();
+            entry->type     = type;
+            entry->code     = code;
+            entry->crc      = entryCrc(entry);
+            if (eepromWriter_write((uintptr_t)&historyRing[nextSequence & (eHISTORY_ENTRIES - 1)], entry, sizeof(*entry)))
+            {
+                nextSequence++;
+            }
+            else
+            {
+                lostEntries++;
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Get the sequence number the next history entry will get
+ *
+ * @return sequence number
+ */
+uint16_t history_getNextSequence(void)
+{
+    uint16_t sequence;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        sequence = nextSequence;
+    }
+    return sequence;
+}
+
+
+/**
+ * @brief Get a history entry, entries that are still waiting to be written are returned as well
+ *
+ * @param sequence  sequence number of the entry (only the last eHISTORY_ENTRIES entries are available)
+ * @param entry     requested entry
+ *
+ * @return false if the entry isn't available (overwritten, not logged so far or damaged)
+ */
+bool history_getEntry(uint16_t sequence, historyEntry_t *entry)
+{
+    bool pending = false;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        const historyEntry_t *pendingEntry = &pendingEntries[sequence & (ePENDING_ENTRIES - 1)];
+        if ((pendingEntry->sequence == sequence) && eepromWriter_pending(pendingEntry))
+        {
+            *entry  = *pendingEntry;
+            pending = true;
+        }
+    }
+    if (!pending)
+    {
+        eepromWriter_read(entry, (uintptr_t)&historyRing[sequence & (eHISTORY_ENTRIES - 1)], sizeof(*entry));
+    }
+
+    return ((uint16_t)(history_getNextSequence() - sequence - 1) < eHISTORY_ENTRIES) && (entry->sequence == sequence) &&
+           (entry->crc == entryCrc(entry));
+}
+
+
+/**
+ * @brief Get the number of entries that couldn't be logged
+ *
+ * @return entries lost since startup because the EEPROM writer was too slow
+ */
+uint16_t history_getLostEntries(void)
+{
+    uint16_t lost;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        lost = lostEntries;
+    }
+    return lost;
+}
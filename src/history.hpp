@@ -0,0 +1,43 @@
+#if not defined HISTORY_H
+#define HISTORY_H
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+enum
+{
+    eHISTORY_ENTRIES = 32,          // entries kept in EEPROM, has to be a power of two
+};
+
+
+// history entry types, the meaning of the code depends on the type
+enum
+{
+    eHISTORY_STARTUP        = 0,    // board has been started, code is 0
+    eHISTORY_ERROR          = 1,    // code is the error number (eERROR_...)
+    eHISTORY_WATCHDOG_STATE = 2,    // code is the new watchdog state (eWATCHDOG_STATE_...)
+    eHISTORY_SELF_TEST      = 3,    // code is the self test outcome (passed or failed test state)
+};
+
+
+typedef struct
+{
+    uint16_t sequence;              // incremented with each entry, the entry is stored at sequence % eHISTORY_ENTRIES
+    uint16_t boot;                  // boot counter, incremented with each startup
+    uint32_t ticks;                 // ms since startup
+    uint8_t  type;                  // eHISTORY_...
+    uint16_t code;
+    uint16_t crc;                   // CRC16 X25 of all fields above
+} historyEntry_t;
+
+
+void history_setup(void);
+void history_log(uint8_t type, uint16_t code);
+uint16_t history_getNextSequence(void);
+bool history_getEntry(uint16_t sequence, historyEntry_t *entry);
+uint16_t history_getLostEntries(void);
+
+
+#endif
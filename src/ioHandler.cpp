@@ -5,6 +5,7 @@
 #include "ioHandler.hpp"
 #include "timer.hpp"
 #include "watchdog.hpp"
+#include "config.hpp"
 #include "debug.hpp"
 
 
@@ -21,14 +22,93 @@
 static bool outputs[eSUPPORTED_OUTPUTS];    // output states,    false per default
 static bool inputs[eSUPPORTED_INPUTS];      // input states,     false per default
 
+// per input filter configuration and state, rise and fall are samples needed to switch to ON (OFF), see eINPUT_FILTER_...
+typedef struct
+{
+    uint8_t mode;
+    uint8_t rise;
+    uint8_t fall;
+    uint8_t counter;        // consecutive and integrator filter: samples seen with the opposite state
+    uint8_t history;        // majority filter: last samples, bit 0 is the latest one
+} inputFilter_t;
+static inputFilter_t inputFilters[eSUPPORTED_INPUTS];      // eINPUT_FILTER_NONE per default
+
+static_assert(!(eINPUT_EVENTS & (eINPUT_EVENTS - 1)), "eINPUT_EVENTS has to be a power of two");
+static inputEvent_t inputEvents[eINPUT_EVENTS];     // ring of the last input changes, index is the lower bits of the sequence number
+static uint16_t nextEventSequence;                  // sequence number of the next event
+
+// output drive profiles, held outputs are switched by the Timer2 PWM ISRs instead of the cyclic task
+typedef struct
+{
+    uint16_t pullInTime;        // ticks with full drive after switching ON
+    bool     hold;              // after pull-in the output is driven with holdDuty
+} outputProfile_t;
+static outputProfile_t outputProfiles[eSUPPORTED_OUTPUTS];     // full drive per default
+static uint16_t pullInRemaining[eSUPPORTED_OUTPUTS];           // ticks until an ON output is held
+static uint8_t  holdDuty;                                       // duty shared by all held outputs (OCR2B + 1), 0 = no output is held
+
+// timed outputs, after the duration the output reverts to the state it had before, any other change of the output cancels it
+typedef struct
+{
+    uint16_t remaining;         // ticks until the output reverts, 0 = no timed output
+    bool     revertValue;
+} timedOutput_t;
+static timedOutput_t timedOutputs[eSUPPORTED_OUTPUTS];
+
+// output sequence, steps are only changed while the sequence is not running
+static sequenceStep_t sequenceSteps[eSEQUENCE_STEPS];
+static struct
+{
+    uint8_t  state;             // eSEQUENCE_...
+    uint8_t  steps;             // number of steps to be executed
+    uint8_t  nextStep;          // step to be started when the current one is over
+    uint16_t remaining;         // ticks until the current step is over
+    uint8_t  usedOutputs;       // outputs changed by the sequence so far, they are switched OFF on abort
+} sequence;
+
+// staggered switching, at most maxPullIns outputs are switched ON within pullInGap ticks, outputs switched OFF are never delayed
+static uint8_t  maxPullIns;                 // 0 = no limit (default)
+static uint16_t pullInGap;
+static uint16_t gapRemaining;               // ticks until the current window ends, 0 = no window active
+static uint8_t  windowPullIns;              // outputs switched ON within the current window
+static uint8_t  drivenOutputs;              // outputs that are switched ON currently (bit 0 = output 0)
+static uint8_t  sequencePullIns;            // outputs switched ON by the current sequence step, they aren't delayed by the scheduler
+
+// edge capture ring, head is only written by the pin change ISR and tail only by the main loop, so no locking is needed
+static_assert(!(eINPUT_EDGES & (eINPUT_EDGES - 1)) && (eINPUT_EDGES < 256), "eINPUT_EDGES has to be a power of two smaller than 256");
+static inputEdge_t inputEdges[eINPUT_EDGES];
+static volatile uint8_t edgeHead;                   // next entry written by the ISR
+static volatile uint8_t edgeTail;                   // oldest entry not removed so far
+static volatile uint16_t lostEdges;                 // edges lost since the ring was full
+static bool    edgeCaptureEnabled;
+static uint8_t lastEdgePins;                        // input pins seen by the previous pin change interrupt
+
+// pulse counters, count is written by the counting ISR and gate values by the timer ISR
+typedef struct
+{
+    uint32_t count;
+    uint32_t gateStart;         // count at the start of the current gate time
+    uint32_t gateCount;
+    uint16_t gateTime;          // 0 = counter disabled
+    uint16_t gateRemaining;     // ticks until the current gate time has elapsed
+    bool     gateValid;         // at least one gate time has elapsed
+} pulseCounter_t;
+static pulseCounter_t pulseCounters[eSUPPORTED_INPUTS];
+static uint8_t countedPins;                         // PORTD pins counted by pin change interrupt
+
 static bool highCycle = false;              // switch all outputs synchronized, in highCycle phase switch all active outputs ON, in !highCycle phase switch all active outputs OFF
 
+// pulsed outputs are loaded from the configuration at startup, the watchdog port is pulsed always with highCycle!!! This is not intended to save energy!
+static uint8_t pulsedOutputs;                           // bit mask of pulsed outputs
+static uint8_t pulsePeriods[eSUPPORTED_OUTPUTS];        // ticks between two toggles of a pulsed output
+static uint8_t pulseTimers[eSUPPORTED_OUTPUTS];         // ticks until a pulsed output toggles
+static uint8_t pulseHighOutputs;                        // pulsed outputs in their ON phase
+
 #define WATCHDOG_OUTPUT D6
 
-static const uint8_t inputPorts[eSUPPORTED_INPUTS] = {D2, D3, D4, D5};
-static const uint8_t outputPorts[eSUPPORTED_OUTPUTS + ADDITIONAL_OUTPUTS]    = {D7, D8, D9, D11, D12, A1, A2, /* watchdog output... */ WATCHDOG_OUTPUT};        // all output ports including the watchdog output port that has to be the last given one!!!
-static const bool    pulsedPorts[eSUPPORTED_OUTPUTS + ADDITIONAL_OUTPUTS]    = {1,  1,  1,  0,   0,   0,  0,  /* watchdog output... */ 1};         // a value > 0 means output has to be pulsed, last value relates to the watchdog port and is ignored (pulsed always)!!! This is not intended to save energy!
-static const uint8_t ledPin = D13;
+static constexpr uint8_t inputPorts[eSUPPORTED_INPUTS] = {D2, D3, D4, D5};
+static constexpr uint8_t outputPorts[eSUPPORTED_OUTPUTS + ADDITIONAL_OUTPUTS]    = {D7, D8, D9, D11, D12, A1, A2, /* watchdog output... */ WATCHDOG_OUTPUT};        // all output ports including the watchdog output port that has to be the last given one!!!
+static constexpr uint8_t ledPin = D13;
 static const uint8_t resetLockPin = A0;         // needs to be switched between ON and hi-Z
 
 enum
@@ -39,120 +119,1005 @@ enum
 static const uint8_t watchDogPort  = outputPorts[eWATCH_DOG_INDEX];
 
 
+// AVR ports used by the board, all pins are resolved at compile time to one of them and a bit mask
+enum
+{
+    ePORT_B,
+    ePORT_C,
+    ePORT_D,
+    ePORTS,
+};
+
+
+// arduino nano pin mapping: D0..D7 are PORTD, D8..D13 are PORTB and A0..A5 are PORTC
+static constexpr uint8_t pinToPort(uint8_t pin)
+{
+    return (pin < D8) ? ePORT_D : ((pin < PIN_A0) ? ePORT_B : ePORT_C);
+}
+
+
+static constexpr uint8_t pinToMask(uint8_t pin)
+{
+    return 1 << ((pin < D8) ? pin : ((pin < PIN_A0) ? (pin - D8) : (pin - PIN_A0)));
+}
+
+
+// collect the bit masks of all given pins that belong to the given port
+static constexpr uint8_t portMask(const uint8_t *pins, uint8_t pinCount, uint8_t port)
+{
+    return pinCount ? (((pinToPort(pins[0]) == port) ? pinToMask(pins[0]) : 0) | portMask(pins + 1, pinCount - 1, port)) : 0;
+}
+
+
+// port bits written by the cyclic task (outputs, watchdog and LED), all other bits of a port are kept untouched
+static constexpr uint8_t managedPortMask[ePORTS] = {
+    (uint8_t)(portMask(outputPorts, sizeof(outputPorts), ePORT_B) | ((pinToPort(ledPin) == ePORT_B) ? pinToMask(ledPin) : 0)),
+    (uint8_t)(portMask(outputPorts, sizeof(outputPorts), ePORT_C) | ((pinToPort(ledPin) == ePORT_C) ? pinToMask(ledPin) : 0)),
+    (uint8_t)(portMask(outputPorts, sizeof(outputPorts), ePORT_D) | ((pinToPort(ledPin) == ePORT_D) ? pinToMask(ledPin) : 0)),
+};
+
+
+// ports containing at least one input, only these ones will be read
+static constexpr uint8_t inputPortMask[ePORTS] = {
+    portMask(inputPorts, sizeof(inputPorts), ePORT_B),
+    portMask(inputPorts, sizeof(inputPorts), ePORT_C),
+    portMask(inputPorts, sizeof(inputPorts), ePORT_D),
+};
+
+
+// edge capture uses pin change interrupt 2, so all inputs have to be at PORTD (PCINT16..23 are PD0..PD7)
+static_assert(!inputPortMask[ePORT_B] && !inputPortMask[ePORT_C], "edge capture expects all inputs at PORTD");
+
+// input 1 is counted by external interrupt INT1, the other inputs (except the watchdog readback) by pin change interrupt
+enum
+{
+    eINT1_INPUT = 1,
+};
+static_assert(inputPorts[eINT1_INPUT] == D3, "INT1 is at D3");
+
+
+typedef struct
+{
+    uint8_t port;       // ePORT_B, ePORT_C or ePORT_D
+    uint8_t mask;       // bit of the pin inside the port
+} portPin_t;
+
+#define PORT_PIN(pin) { pinToPort(pin), pinToMask(pin) }
+
+static const portPin_t outputPins[eSUPPORTED_OUTPUTS + ADDITIONAL_OUTPUTS] = {
+    PORT_PIN(outputPorts[0]), PORT_PIN(outputPorts[1]), PORT_PIN(outputPorts[2]), PORT_PIN(outputPorts[3]),
+    PORT_PIN(outputPorts[4]), PORT_PIN(outputPorts[5]), PORT_PIN(outputPorts[6]), PORT_PIN(outputPorts[7]),
+};
+
+static const portPin_t inputPins[eSUPPORTED_INPUTS] = {
+    PORT_PIN(inputPorts[0]), PORT_PIN(inputPorts[1]), PORT_PIN(inputPorts[2]), PORT_PIN(inputPorts[3]),
+};
+
+static const portPin_t ledPortPin = PORT_PIN(ledPin);
+
+
+static uint8_t portImage[ePORTS];           // new values of all managed port bits, collected during a cyclic task and written once at its end
+static volatile uint8_t heldPortMask[ePORTS];   // port bits of held outputs, they are switched by the PWM ISRs and excluded from writePorts()
+static bool ledState = true;                // LED is switched ON in setup
+
+
+// read the PIN register of the given port
+static inline uint8_t readPort(uint8_t port)
+{
+    switch (port)
+    {
+        case ePORT_B:
+            return PINB;
+        case ePORT_C:
+            return PINC;
+        default:
+            return PIND;
+    }
+}
+
+
+// write all collected port values at once, so all outputs of a port change at the same time (interrupts are disabled since it's called from the timer ISR)
+static inline void writePorts(void)
+{
+    uint8_t maskB = managedPortMask[ePORT_B] & ~heldPortMask[ePORT_B];
+    uint8_t maskC = managedPortMask[ePORT_C] & ~heldPortMask[ePORT_C];
+    uint8_t maskD = managedPortMask[ePORT_D] & ~heldPortMask[ePORT_D];
+    PORTB = (PORTB & ~maskB) | (portImage[ePORT_B] & maskB);
+    PORTC = (PORTC & ~maskC) | (portImage[ePORT_C] & maskC);
+    PORTD = (PORTD & ~maskD) | (portImage[ePORT_D] & maskD);
+}
+
+
+// hold PWM period start, switch all held outputs ON
+ISR(TIMER2_COMPA_vect)
+{
+    PORTB |= heldPortMask[ePORT_B];
+    PORTC |= heldPortMask[ePORT_C];
+    PORTD |= heldPortMask[ePORT_D];
+}
+
+
+// hold PWM duty elapsed, switch all held outputs OFF
+ISR(TIMER2_COMPB_vect)
+{
+    PORTB &= ~heldPortMask[ePORT_B];
+    PORTC &= ~heldPortMask[ePORT_C];
+    PORTD &= ~heldPortMask[ePORT_D];
+}
+
+
 // set output port to 1 means toggle it every time this method has been called (outputs and watchdog can be handled, the caller has to ensure that the right output is set!)
 static void setOutputPort(uint8_t outputNumber)
 {
     if (outputNumber < sizeof(outputPorts))
     {
-        // toggle watchdog port and pulsed port but switch ON not-pulsed port
-        if (highCycle || (!pulsedPorts[outputNumber] && (outputNumber != eWATCH_DOG_INDEX)))
+        // toggle watchdog port and pulsed port but switch ON not-pulsed port
+        uint8_t outputBit = 1 << outputNumber;
+        if ((outputNumber == eWATCH_DOG_INDEX) ? highCycle : (!(pulsedOutputs & outputBit) || (pulseHighOutputs & outputBit)))
+        {
+            portImage[outputPins[outputNumber].port] |= outputPins[outputNumber].mask;
+        }
+        else
+        {
+            portImage[outputPins[outputNumber].port] &= ~outputPins[outputNumber].mask;
+        }
+    }
+}
+
+
+// switch output port off (outputs and watchdog can be handled, the caller has to ensure that the right output is cleared!)
+static void clearOutputPort(uint8_t outputNumber)
+{
+    if (outputNumber < sizeof(outputPorts))
+    {
+        portImage[outputPins[outputNumber].port] &= ~outputPins[outputNumber].mask;
+    }
+}
+
+
+// read input pin and return current state as boolean
+static bool getInputPort(uint8_t inputNumber)
+{
+    bool value = false;
+    if (inputNumber < eSUPPORTED_INPUTS)
+    {
+        value = ((readPort(inputPins[inputNumber].port) & inputPins[inputNumber].mask) != 0);
+    }
+
+    return value;
+}
+
+
+// set watchdog port to 1 (OK)
+static inline void setWatchdogPort(void)
+{
+    setOutputPort(eWATCH_DOG_INDEX);
+}
+
+
+// set watchdog port to 0 (ERROR)
+static inline void clearWatchdogPort(void)
+{
+    clearOutputPort(eWATCH_DOG_INDEX);
+}
+
+
+// lock reset pin to prevent reset during UART connection
+static inline void lockResetPort(void)
+{
+    // set pin to HIGH
+    digitalWrite(resetLockPin, HIGH);       // ensure it's set to HIGH as soon as it will be configured as output (since it's currently an input the pull-up will be switched now, what is OK)
+    pinMode(resetLockPin, OUTPUT);
+}
+
+
+// unlock reset pin, reset during UART connection is possible and e.g. new firmware can be installed
+static inline void unlockResetPort(void)
+{
+    // set pin to hi-Z
+    pinMode(resetLockPin, INPUT);           // meanwhile set it to hi-Z
+    digitalWrite(resetLockPin, LOW);        // disable pullup because "HIGH" in input mode means pullup is enabled
+}
+
+
+// setup used io ports
+void ioHandler_setup(void)
+{
+    for (uint8_t index = 0; index < sizeof(outputPorts); index++)
+    {
+        pinMode(outputPorts[index], OUTPUT);
+    }
+
+    for (uint8_t index = 0; index < sizeof(inputPorts); index++)
+    {
+        pinMode(inputPorts[index], INPUT);
+    }
+
+    // pulsed outputs, all of them start synchronized with the ON phase
+    const config_t *config = config_get();
+    pulsedOutputs = config->pulsedOutputs;
+    for (uint8_t index = 0; index < eSUPPORTED_OUTPUTS; index++)
+    {
+        pulsePeriods[index] = config->pulsePeriods[index];
+        pulseTimers[index]  = 1;
+    }
+
+    // arduino nano LED used for diagnosis
+    pinMode(ledPin, OUTPUT);
+    digitalWrite(ledPin, HIGH);
+
+    // setup reset lock pin (default behavior, so it's not necessary)
+    //digitalWrite(resetLockPin, LOW);        // ensure pullup is disabled
+    //pinMode(resetLockPin, INPUT);           // meanwhile set it to hi-Z
+}
+
+
+// set output state
+void ioHandler_setOutput(uint16_t index, uint8_t value)
+{
+    if (index < eSUPPORTED_OUTPUTS)
+    {
+        noInterrupts();
+        outputs[index] = (value != 0);
+        timedOutputs[index].remaining = 0;
+        interrupts();
+    }
+}
+
+
+// get output state
+bool ioHandler_getOutput(uint16_t index)
+{
+    bool result = false;
+    if (index < eSUPPORTED_OUTPUTS)
+    {
+        result = outputs[index];
+    }
+    return result;
+}
+
+
+/**
+ * @brief Set several outputs at once, all of them will be switched within the same cyclic task
+ *
+ * @param mask      bit mask of outputs to be changed (bit 0 = output 0)
+ * @param values    new output states (bit 0 = output 0), only bits set in mask are used
+ */
+void ioHandler_setOutputs(uint8_t mask, uint8_t values)
+{
+    noInterrupts();
+    for (uint8_t index = 0; index < eSUPPORTED_OUTPUTS; index++)
+    {
+        if (mask & (1 << index))
+        {
+            outputs[index] = ((values & (1 << index)) != 0);
+            timedOutputs[index].remaining = 0;
+        }
+    }
+    interrupts();
+}
+
+
+/**
+ * @brief Set an output for a given time, afterwards it reverts to its current state (if it's already timed to the state before the first timed change)
+ *
+ * @param index     output
+ * @param value     state during the given time
+ * @param duration  ticks until the output reverts, 0 cancels a running timed output (the output keeps its current state)
+ */
+void ioHandler_setTimedOutput(uint16_t index, uint8_t value, uint16_t duration)
+{
+    if (index < eSUPPORTED_OUTPUTS)
+    {
+        noInterrupts();
+        timedOutput_t *timedOutput = &timedOutputs[index];
+        if (duration)
+        {
+            if (!timedOutput->remaining)
+            {
+                timedOutput->revertValue = outputs[index];
+            }
+            outputs[index] = (value != 0);
+        }
+        timedOutput->remaining = duration;
+        interrupts();
+    }
+}
+
+
+/**
+ * @brief Get the state of a timed output
+ *
+ * @param index         output
+ * @param revertValue   state the output reverts to (its current state if it's not timed)
+ *
+ * @return ticks until the output reverts, 0 if it's not timed
+ */
+uint16_t ioHandler_getTimedOutput(uint16_t index, bool *revertValue)
+{
+    uint16_t remaining = 0;
+    *revertValue = false;
+    if (index < eSUPPORTED_OUTPUTS)
+    {
+        noInterrupts();
+        remaining    = timedOutputs[index].remaining;
+        *revertValue = remaining ? timedOutputs[index].revertValue : outputs[index];
+        interrupts();
+    }
+    return remaining;
+}
+
+
+/**
+ * @brief Get all output states
+ *
+ * @return bit mask of output states (bit 0 = output 0)
+ */
+uint8_t ioHandler_getOutputs(void)
+{
+    uint8_t result = 0;
+    for (uint8_t index = 0; index < eSUPPORTED_OUTPUTS; index++)
+    {
+        if (outputs[index])
+        {
+            result |= (1 << index);
+        }
+    }
+    return result;
+}
+
+
+/**
+ * @brief Get all input states, all of them have been sampled within the same cyclic task
+ *
+ * @return bit mask of input states (bit 0 = input 0)
+ */
+uint8_t ioHandler_getInputs(void)
+{
+    uint8_t result = 0;
+    noInterrupts();
+    for (uint8_t index = 0; index < eSUPPORTED_INPUTS; index++)
+    {
+        if (inputs[index])
+        {
+            result |= (1 << index);
+        }
+    }
+    interrupts();
+    return result;
+}
+
+
+// convert PORTD pin states into an input bit mask (bit 0 = input 0)
+static inline uint8_t pinsToInputs(uint8_t pins)
+{
+    uint8_t result = 0;
+    for (uint8_t index = 0; index < eSUPPORTED_INPUTS; index++)
+    {
+        if (pins & inputPins[index].mask)
+        {
+            result |= (1 << index);
+        }
+    }
+    return result;
+}
+
+
+// count rising edges of input 1
+ISR(INT1_vect)
+{
+    pulseCounters[eINT1_INPUT].count++;
+}
+
+
+// count rising edges of the counted inputs and log each change of an input pin with a sub tick timestamp
+ISR(PCINT2_vect)
+{
+    uint8_t counts;
+    uint32_t ticks = timer_getTimestamp(&counts);
+    uint8_t pins = PIND & inputPortMask[ePORT_D];
+
+    uint8_t rising = pins & ~lastEdgePins & countedPins;
+    if (rising)
+    {
+        for (uint8_t index = 0; index < eSUPPORTED_INPUTS; index++)
+        {
+            if (rising & inputPins[index].mask)
+            {
+                pulseCounters[index].count++;
+            }
+        }
+    }
+
+    // several pins can change with a single interrupt and a short pulse can be over before the pins are read
+    if (edgeCaptureEnabled && (pins != lastEdgePins))
+    {
+        uint8_t nextHead = (edgeHead + 1) & (eINPUT_EDGES - 1);
+        if (nextHead != edgeTail)
+        {
+            inputEdge_t *edge = &inputEdges[edgeHead];
+            edge->ticks  = ticks;
+            edge->counts = counts;
+            edge->inputs = pinsToInputs(pins);
+            edgeHead = nextHead;
+        }
+        else if (lostEdges < 0xFFFF)
+        {
+            lostEdges++;
+        }
+    }
+    lastEdgePins = pins;
+}
+
+
+// enable pin change interrupt for all pins needed for edge capture and pulse counting, to be called with interrupts disabled
+static void updatePinChangeInterrupt(void)
+{
+    PCMSK2 = (edgeCaptureEnabled ? inputPortMask[ePORT_D] : 0) | countedPins;
+    if (PCMSK2)
+    {
+        PCICR |= (1 << PCIE2);
+    }
+    else
+    {
+        PCICR &= ~(1 << PCIE2);
+    }
+    lastEdgePins = PIND & inputPortMask[ePORT_D];
+}
+
+
+/**
+ * @brief Enable or disable edge capture, all captured edges and the lost edges counter are cleared
+ *
+ * @param enable    true to capture each change of an input pin by pin change interrupt
+ */
+void ioHandler_enableEdgeCapture(bool enable)
+{
+    noInterrupts();
+    edgeCaptureEnabled = enable;
+    updatePinChangeInterrupt();
+    edgeTail = edgeHead;
+    lostEdges = 0;
+    interrupts();
+}
+
+
+/**
+ * @brief Get the number of captured edges that haven't been removed so far
+ *
+ * @return number of edges
+ */
+uint8_t ioHandler_getEdgeCount(void)
+{
+    return (edgeHead - edgeTail) & (eINPUT_EDGES - 1);
+}
+
+
+/**
+ * @brief Get a captured edge without removing it
+ *
+ * @param index     0 for the oldest edge, up to ioHandler_getEdgeCount() - 1
+ * @param edge      edge data
+ *
+ * @return true if the edge exists
+ */
+bool ioHandler_getEdge(uint8_t index, inputEdge_t *edge)
+{
+    bool result = false;
+    if (index < ioHandler_getEdgeCount())
+    {
+        // ISR never writes entries between tail and head
+        *edge = inputEdges[(edgeTail + index) & (eINPUT_EDGES - 1)];
+        result = true;
+    }
+    return result;
+}
+
+
+/**
+ * @brief Remove the oldest captured edges
+ *
+ * @param count     number of edges to be removed, limited to the captured ones
+ */
+void ioHandler_removeEdges(uint8_t count)
+{
+    uint8_t available = ioHandler_getEdgeCount();
+    edgeTail = (edgeTail + ((count < available) ? count : available)) & (eINPUT_EDGES - 1);
+}
+
+
+/**
+ * @brief Get the number of edges that have been lost because the ring was full
+ *
+ * @return lost edges since edge capture has been enabled
+ */
+uint16_t ioHandler_getLostEdges(void)
+{
+    noInterrupts();
+    uint16_t result = lostEdges;
+    interrupts();
+    return result;
+}
+
+
+/**
+ * @brief Set a sequence step, not possible while the sequence is running
+ *
+ * @param index     step (up to eSEQUENCE_STEPS - 1)
+ * @param step      outputs to be changed, their new states and the duration of the step
+ *
+ * @return true if the step has been set
+ */
+bool ioHandler_setSequenceStep(uint8_t index, const sequenceStep_t *step)
+{
+    bool result = false;
+    noInterrupts();
+    if ((index < eSEQUENCE_STEPS) && (sequence.state != eSEQUENCE_RUNNING))
+    {
+        sequenceSteps[index] = *step;
+        result = true;
+    }
+    interrupts();
+    return result;
+}
+
+
+/**
+ * @brief Get a sequence step
+ *
+ * @param index     step (up to eSEQUENCE_STEPS - 1)
+ * @param step      outputs to be changed, their new states and the duration of the step
+ */
+void ioHandler_getSequenceStep(uint8_t index, sequenceStep_t *step)
+{
+    if (index < eSEQUENCE_STEPS)
+    {
+        noInterrupts();
+        *step = sequenceSteps[index];
+        interrupts();
+    }
+}
+
+
+/**
+ * @brief Start the sequence (again) with its first step, the first step is executed with the next tick
+ *
+ * @param steps     number of steps to be executed (1 up to eSEQUENCE_STEPS)
+ */
+void ioHandler_startSequence(uint8_t steps)
+{
+    if (steps && (steps <= eSEQUENCE_STEPS))
+    {
+        noInterrupts();
+        sequence.state       = eSEQUENCE_RUNNING;
+        sequence.steps       = steps;
+        sequence.nextStep    = 0;
+        sequence.remaining   = 0;
+        sequence.usedOutputs = 0;
+        interrupts();
+    }
+}
+
+
+/**
+ * @brief Stop the sequence, all outputs keep their current states
+ */
+void ioHandler_stopSequence(void)
+{
+    noInterrupts();
+    if (sequence.state == eSEQUENCE_RUNNING)
+    {
+        sequence.state = eSEQUENCE_IDLE;
+    }
+    interrupts();
+}
+
+
+/**
+ * @brief Get the sequence state
+ *
+ * @param step      current step (the last executed one if the sequence isn't running anymore)
+ * @param remaining ticks until the current step is over
+ *
+ * @return eSEQUENCE_...
+ */
+uint8_t ioHandler_getSequenceState(uint8_t *step, uint16_t *remaining)
+{
+    noInterrupts();
+    uint8_t state = sequence.state;
+    *step      = sequence.nextStep ? (sequence.nextStep - 1) : 0;
+    *remaining = (state == eSEQUENCE_RUNNING) ? sequence.remaining : 0;
+    interrupts();
+    return state;
+}
+
+
+/**
+ * @brief Check if the sequence steps switch ON not more outputs at once than the pull-in schedule allows, steps bypass the schedule
+ *        to keep their timing
+ *
+ * @param steps     number of steps to be checked (1 up to eSEQUENCE_STEPS)
+ *
+ * @return true if no step switches ON more than maxPullIns outputs (always without limit)
+ */
+bool ioHandler_sequenceFitsSchedule(uint8_t steps)
+{
+    bool result = true;
+    noInterrupts();
+    for (uint8_t index = 0; maxPullIns && (index < steps) && (index < eSEQUENCE_STEPS); index++)
+    {
+        uint8_t pullIns = 0;
+        for (uint8_t values = sequenceSteps[index].values; values; values >>= 1)
+        {
+            pullIns += values & 1;
+        }
+        if (pullIns > maxPullIns)
+        {
+            result = false;
+        }
+    }
+    interrupts();
+    return result;
+}
+
+
+/**
+ * @brief Limit the outputs that are switched ON together, outputs waiting for their pull-in are switched ON in index order
+ *
+ * @param pullIns   outputs that can be switched ON within a gap, 0 = no limit
+ * @param gap       ticks (1 up to eMAX_PULL_IN_GAP) between pull-ins of the next outputs, ignored without limit
+ */
+void ioHandler_setPullInSchedule(uint8_t pullIns, uint16_t gap)
+{
+    if ((gap <= eMAX_PULL_IN_GAP) && (gap || !pullIns))
+    {
+        noInterrupts();
+        maxPullIns    = pullIns;
+        pullInGap     = gap;
+        gapRemaining  = 0;
+        windowPullIns = 0;
+        interrupts();
+    }
+}
+
+
+/**
+ * @brief Get the delay until all outputs that are set to ON are switched ON by the scheduler
+ *
+ * @return ticks until the last waiting output will be switched ON, 0 if all of them are switched ON with the next tick
+ */
+uint16_t ioHandler_getPullInDelay(void)
+{
+    uint16_t delay = 0;
+    noInterrupts();
+    if (maxPullIns && watchdog_running())
+    {
+        uint8_t waiting = 0;
+        for (uint8_t index = 0; index < eSUPPORTED_OUTPUTS; index++)
+        {
+            if (outputs[index] && !(drivenOutputs & (1 << index)))
+            {
+                waiting++;
+            }
+        }
+
+        uint8_t available = (windowPullIns < maxPullIns) ? (maxPullIns - windowPullIns) : 0;     // pull-ins still possible in the current window (sequence steps may exceed it)
+        if (waiting > available)
+        {
+            uint8_t later = waiting - available;
+            delay = (gapRemaining ? gapRemaining : pullInGap) + ((later - 1) / maxPullIns) * pullInGap;
+        }
+    }
+    interrupts();
+    return delay;
+}
+
+
+/**
+ * @brief Check if an output can be held with a PWM duty cycle
+ *
+ * @param index     output
+ *
+ * @return true for all outputs that are not pulsed (pulsed outputs have to be toggled with each tick)
+ */
+bool ioHandler_holdSupported(uint8_t index)
+{
+    return (index < eSUPPORTED_OUTPUTS) && !(pulsedOutputs & (1 << index));
+}
+
+
+/**
+ * @brief Check if an output can use a hold duty, all held outputs share the same duty
+ *
+ * @param index     output
+ * @param duty      hold duty in percent, 0 = full drive
+ *
+ * @return true for full drive, if no other output is held or if it's the duty the held outputs use already
+ */
+bool ioHandler_holdDutyAvailable(uint8_t index, uint8_t duty)
+{
+    bool othersHeld = false;
+    for (uint8_t output = 0; output < eSUPPORTED_OUTPUTS; output++)
+    {
+        othersHeld |= (output != index) && outputProfiles[output].hold;
+    }
+    return !duty || !othersHeld || (duty == holdDuty);
+}
+
+
+/**
+ * @brief Configure an output as pulsed or not pulsed and store the configuration in EEPROM, only possible while the watchdog is
+ *        not running (so all outputs are OFF) and no other configuration is being written, an output that gets pulsed loses its hold PWM
+ *
+ * @param index         output
+ * @param pulsed        output is toggled every pulsePeriod ticks instead of being switched ON
+ * @param pulsePeriod   ticks between two toggles (1 up to eMAX_PULSE_PERIOD)
+ *
+ * @return true if the configuration has been changed and its write has been started
+ */
+bool ioHandler_setOutputConfig(uint8_t index, bool pulsed, uint8_t pulsePeriod)
+{
+    bool result = false;
+    if ((index < eSUPPORTED_OUTPUTS) && pulsePeriod && (pulsePeriod <= eMAX_PULSE_PERIOD) && !watchdog_running())
+    {
+        config_t config = *config_get();
+        config.pulsedOutputs       = pulsed ? (config.pulsedOutputs | (1 << index)) : (config.pulsedOutputs & ~(1 << index));
+        config.pulsePeriods[index] = pulsePeriod;
+        result = config_write(&config);
+    }
+
+    if (result)
+    {
+        if (pulsed && outputProfiles[index].hold)
         {
-            digitalWrite(outputPorts[outputNumber], HIGH);
+            ioHandler_setOutputProfile(index, outputProfiles[index].pullInTime, 0);
         }
-        else
+
+        // restart all pulses synchronized
+        noInterrupts();
+        pulsedOutputs = config_get()->pulsedOutputs;
+        pulsePeriods[index] = pulsePeriod;
+        pulseHighOutputs = 0;
+        for (uint8_t output = 0; output < eSUPPORTED_OUTPUTS; output++)
         {
-            digitalWrite(outputPorts[outputNumber], LOW);
+            pulseTimers[output] = 1;
         }
+        interrupts();
     }
+    return result;
 }
 
 
-// switch output port off (outputs and watchdog can be handled, the caller has to ensure that the right output is cleared!)
-static void clearOutputPort(uint8_t outputNumber)
+/**
+ * @brief Get the configuration of an output
+ *
+ * @param index         output
+ * @param pulsePeriod   ticks between two toggles of a pulsed output
+ *
+ * @return true if the output is pulsed
+ */
+bool ioHandler_getOutputConfig(uint8_t index, uint8_t *pulsePeriod)
 {
-    if (outputNumber < sizeof(outputPorts))
+    bool pulsed = false;
+    if (index < eSUPPORTED_OUTPUTS)
     {
-        digitalWrite(outputPorts[outputNumber], LOW);
+        pulsed       = ((pulsedOutputs & (1 << index)) != 0);
+        *pulsePeriod = pulsePeriods[index];
     }
+    return pulsed;
 }
 
 
-// read input pin and return current state as boolean
-static bool getInputPort(uint8_t inputNumber)
+/**
+ * @brief Set the drive profile of an output, Timer2 creates the hold PWM (20kHz) as long as at least one output uses it
+ *
+ * @param index         output
+ * @param pullInTime    ticks with full drive after switching the output ON (up to eMAX_PULL_IN_TIME)
+ * @param duty          PWM duty in percent (up to eMAX_HOLD_DUTY) after pull-in, it's shared by all held outputs, 0 = full drive,
+ *                      a held output needs a pull-in time and a duty differing from the one of the other held outputs is rejected
+ */
+void ioHandler_setOutputProfile(uint8_t index, uint16_t pullInTime, uint8_t duty)
 {
-    bool value = false;
-    if (inputNumber < eSUPPORTED_INPUTS)
+    enum
     {
-        value = (digitalRead(inputPorts[inputNumber]) != 0);
-    }
+        eHOLD_PWM_TOP = 99,         // 16MHz / 8 / (99 + 1) = 20kHz, so a duty in percent is the compare value + 1
+    };
 
-    return value;
-}
+    if (ioHandler_holdSupported(index) && (pullInTime <= eMAX_PULL_IN_TIME) && (duty <= eMAX_HOLD_DUTY) && (pullInTime || !duty) &&
+        ioHandler_holdDutyAvailable(index, duty))
+    {
+        noInterrupts();
+        outputProfiles[index].pullInTime = pullInTime;
+        outputProfiles[index].hold       = (duty != 0);
+        pullInRemaining[index]           = pullInTime;      // an output that is ON already is pulled in again
 
+        bool holdUsed = false;
+        for (uint8_t output = 0; output < eSUPPORTED_OUTPUTS; output++)
+        {
+            holdUsed |= outputProfiles[output].hold;
+        }
 
-// set watchdog port to 1 (OK)
-static inline void setWatchdogPort(void)
-{
-    setOutputPort(eWATCH_DOG_INDEX);
+        if (duty)
+        {
+            holdDuty = duty;
+            OCR2B = duty - 1;
+        }
+        if (holdUsed && !TCCR2B)
+        {
+            // CTC mode with OCR2A as top, prescaler 8, compare A starts a PWM period and compare B ends the duty
+            TCCR2A = (1 << WGM21);
+            OCR2A  = eHOLD_PWM_TOP;
+            TCNT2  = 0;
+            TIMSK2 = (1 << OCIE2A) | (1 << OCIE2B);
+            TCCR2B = (1 << CS21);
+        }
+        else if (!holdUsed)
+        {
+            TCCR2B = 0;
+            TIMSK2 = 0;
+            holdDuty = 0;
+        }
+        interrupts();
+    }
 }
 
 
-// set watchdog port to 0 (ERROR)
-static inline void clearWatchdogPort(void)
+/**
+ * @brief Check if an input can be used as pulse counter
+ *
+ * @param index     input
+ *
+ * @return true for all inputs except the watchdog readback
+ */
+bool ioHandler_counterSupported(uint8_t index)
 {
-    clearOutputPort(eWATCH_DOG_INDEX);
+    return (index < eSUPPORTED_INPUTS) && (index != eWATCHDOG_TEST_READBACK);
 }
 
 
-// lock reset pin to prevent reset during UART connection
-static inline void lockResetPort(void)
+/**
+ * @brief Enable or disable a pulse counter, the counter and its frequency measurement restart from zero
+ *
+ * @param index     input (see ioHandler_counterSupported())
+ * @param gateTime  gate time in ticks for the frequency measurement (up to eMAX_GATE_TIME), 0 disables the counter
+ */
+void ioHandler_setCounter(uint8_t index, uint16_t gateTime)
 {
-    // set pin to HIGH
-    digitalWrite(resetLockPin, HIGH);       // ensure it's set to HIGH as soon as it will be configured as output (since it's currently an input the pull-up will be switched now, what is OK)
-    pinMode(resetLockPin, OUTPUT);
+    if (ioHandler_counterSupported(index) && (gateTime <= eMAX_GATE_TIME))
+    {
+        noInterrupts();
+        pulseCounter_t *counter = &pulseCounters[index];
+        counter->count         = 0;
+        counter->gateStart     = 0;
+        counter->gateCount     = 0;
+        counter->gateTime      = gateTime;
+        counter->gateRemaining = gateTime;
+        counter->gateValid     = false;
+
+        if (index == eINT1_INPUT)
+        {
+            // rising edge of INT1
+            EICRA |= (1 << ISC11) | (1 << ISC10);
+            EIFR = (1 << INTF1);                        // forget edges before enabling (flag is cleared by writing a ONE)
+            if (gateTime)
+            {
+                EIMSK |= (1 << INT1);
+            }
+            else
+            {
+                EIMSK &= ~(1 << INT1);
+            }
+        }
+        else
+        {
+            if (gateTime)
+            {
+                countedPins |= inputPins[index].mask;
+            }
+            else
+            {
+                countedPins &= ~inputPins[index].mask;
+            }
+            updatePinChangeInterrupt();
+        }
+        interrupts();
+    }
 }
 
 
-// unlock reset pin, reset during UART connection is possible and e.g. new firmware can be installed
-static inline void unlockResetPort(void)
+/**
+ * @brief Get the values of a pulse counter
+ *
+ * @param index     input (see ioHandler_counterSupported())
+ * @param counter   counter values, all zero if the counter is not enabled
+ */
+void ioHandler_getCounter(uint8_t index, inputCounter_t *counter)
 {
-    // set pin to hi-Z
-    pinMode(resetLockPin, INPUT);           // meanwhile set it to hi-Z
-    digitalWrite(resetLockPin, LOW);        // disable pullup because "HIGH" in input mode means pullup is enabled
+    static const inputCounter_t disabledCounter = { 0, 0, 0, 0 };
+    *counter = disabledCounter;
+    if (ioHandler_counterSupported(index))
+    {
+        noInterrupts();
+        counter->count     = pulseCounters[index].count;
+        counter->gateCount = pulseCounters[index].gateCount;
+        counter->gateTime  = pulseCounters[index].gateTime;
+        bool gateValid     = pulseCounters[index].gateValid;
+        interrupts();
+
+        if (gateValid)
+        {
+            // gateCount * 10^6 / gate time in ms, split into quotient and remainder so 32 bits are enough (the remainder is below
+            // eMAX_GATE_TIME, so remainder * 1000 can't overflow)
+            uint32_t gateMs    = (uint32_t)counter->gateTime * eTICK_TIME;
+            uint32_t remainder = counter->gateCount % gateMs;
+            uint32_t fraction  = remainder * 1000;
+            counter->frequency = (counter->gateCount / gateMs) * 1000000 + (fraction / gateMs) * 1000 + ((fraction % gateMs) * 1000) / gateMs;
+        }
+    }
 }
 
 
-// setup used io ports
-void ioHandler_setup(void)
+/**
+ * @brief Set the filter of an input, the filter starts with the current input state
+ *
+ * @param index     input (the watchdog readback input is never filtered)
+ * @param mode      eINPUT_FILTER_...
+ * @param rise      samples needed to switch the input ON
+ * @param fall      samples needed to switch the input OFF
+ */
+void ioHandler_setInputFilter(uint8_t index, uint8_t mode, uint8_t rise, uint8_t fall)
 {
-    for (uint8_t index = 0; index < sizeof(outputPorts); index++)
-    {
-        pinMode(outputPorts[index], OUTPUT);
-    }
-
-    for (uint8_t index = 0; index < sizeof(inputPorts); index++)
+    if ((index < eSUPPORTED_INPUTS) && (index != eWATCHDOG_TEST_READBACK) && (mode < eINPUT_FILTERS))
     {
-        pinMode(inputPorts[index], INPUT);
+        noInterrupts();
+        inputFilter_t *filter = &inputFilters[index];
+        filter->mode    = mode;
+        filter->rise    = rise;
+        filter->fall    = fall;
+        filter->counter = 0;
+        filter->history = inputs[index] ? 0xFF : 0x00;
+        interrupts();
     }
-
-    // arduino nano LED used for diagnosis
-    pinMode(ledPin, OUTPUT);
-    digitalWrite(ledPin, HIGH);
-
-    // setup reset lock pin (default behavior, so it's not necessary)
-    //digitalWrite(resetLockPin, LOW);        // ensure pullup is disabled
-    //pinMode(resetLockPin, INPUT);           // meanwhile set it to hi-Z
 }
 
 
-// set output state
-void ioHandler_setOutput(uint16_t index, uint8_t value)
+/**
+ * @brief Get the sequence number the next input change event will get
+ *
+ * @return sequence number of next event (all events before it have already happened)
+ */
+uint16_t ioHandler_getNextEventSequence(void)
 {
-    if (index < eSUPPORTED_OUTPUTS)
-    {
-        outputs[index] = (value != 0);
-    }
+    noInterrupts();
+    uint16_t sequence = nextEventSequence;
+    interrupts();
+    return sequence;
 }
 
 
-// get output state
-bool ioHandler_getOutput(uint16_t index)
+/**
+ * @brief Get an input change event, if the requested one has already been overwritten the oldest one still available is returned
+ *
+ * @param sequence  sequence number of the requested event
+ * @param event     event data, event->sequence is the sequence number of the returned event
+ *
+ * @return true if the requested event or a later one has been returned, false if the requested event hasn't happened yet
+ */
+bool ioHandler_getEvent(uint16_t sequence, inputEvent_t *event)
 {
     bool result = false;
-    if (index < eSUPPORTED_OUTPUTS)
+    noInterrupts();
+    uint16_t pending = nextEventSequence - sequence;     // number of events from requested one up to the latest one
+    if (pending && (pending <= 0x8000))                  // requested sequence numbers in the future are not available
     {
-        result = outputs[index];
+        if (pending > eINPUT_EVENTS)
+        {
+            sequence = nextEventSequence - eINPUT_EVENTS;    // requested event has been overwritten already, return the oldest one
+        }
+        *event = inputEvents[sequence & (eINPUT_EVENTS - 1)];
+        result = true;
     }
+    interrupts();
     return result;
 }
 
@@ -172,16 +1137,7 @@ bool ioHandler_getInput(uint16_t index)
 // just toggle the led on ledPin
 static void ledToggle(void)
 {
-    if (digitalRead(ledPin))
-    {
-        // LED was ON so switch it OFF now
-        digitalWrite(ledPin, LOW);
-    }
-    else
-    {
-        // LED was OFF so switch it ON now
-        digitalWrite(ledPin, HIGH);
-    }
+    ledState = !ledState;
 }
 
 
@@ -189,11 +1145,6 @@ static void ledToggle(void)
 static inline void handleLed(void)
 {
     // supported blink modes
-    enum
-    {
-        eLED_TOGGLE_SLOW = 2000 / eTICK_TIME,
-        eLED_TOGGLE_FAST =  100 / eTICK_TIME,
-    };
     static uint16_t ledToggleCounter = 0;
 
     // when counter reaches zero decide what's to do now
@@ -208,13 +1159,13 @@ static inline void handleLed(void)
             case eWATCHDOG_STATE_OK:
                 // toggle led and set slow blink mode
                 ledToggle();
-                ledToggleCounter = eLED_TOGGLE_SLOW;
+                ledToggleCounter = config_getParameter(eCONFIG_LED_SLOW_TIME) / eTICK_TIME;
                 break;
 
             case eWATCHDOG_STATE_ERROR:
                 // toggle led and set fast blink mode
                 ledToggle();
-                ledToggleCounter = eLED_TOGGLE_FAST;
+                ledToggleCounter = config_getParameter(eCONFIG_LED_FAST_TIME) / eTICK_TIME;
                 break;
         }
     }
@@ -223,6 +1174,16 @@ static inline void handleLed(void)
         // counter hasn't reached zero yet
         ledToggleCounter--;
     }
+
+    // LED port bit has to be set in each cycle since port image is written as a whole
+    if (ledState)
+    {
+        portImage[ledPortPin.port] |= ledPortPin.mask;
+    }
+    else
+    {
+        portImage[ledPortPin.port] &= ~ledPortPin.mask;
+    }
 }
 
 
@@ -273,17 +1234,219 @@ static inline void handleResetLock(void)
 
 static inline void handleOutputs(void)
 {
+    uint8_t held[ePORTS] = { 0, 0, 0 };
+
+    if (gapRemaining && !--gapRemaining)
+    {
+        windowPullIns = 0;      // window is over, next outputs can be switched ON
+    }
+
     // set outputs periodically so handler can toggle it!
     for (uint8_t index = 0; index < eSUPPORTED_OUTPUTS; index++)
     {
-        // switch output ON if it is set to ON and there is no watchdog ERROR, otherwise switch it OFF
-        if (outputs[index] && watchdog_running())
+        // switch output ON if it is set to ON and there is no watchdog ERROR (as soon as the scheduler allows it), otherwise switch it OFF immediately,
+        // sequence steps are switched ON without delay to keep their timing but they count for the current window
+        uint8_t outputBit = 1 << index;
+        if (!outputs[index] || !watchdog_running())
+        {
+            drivenOutputs &= ~outputBit;
+        }
+        else if (!(drivenOutputs & outputBit) && (!maxPullIns || (windowPullIns < maxPullIns) || (sequencePullIns & outputBit)))
+        {
+            drivenOutputs |= outputBit;
+            if (maxPullIns)
+            {
+                windowPullIns++;
+                if (!gapRemaining)
+                {
+                    gapRemaining = pullInGap;   // first pull-in starts a new window
+                }
+            }
+        }
+
+        if (drivenOutputs & outputBit)
         {
-            setOutputPort(index);       // if watchdog is running and output is set to ON switch the referring port ON
+            if (outputProfiles[index].hold && !pullInRemaining[index])
+            {
+                held[outputPins[index].port] |= outputPins[index].mask;     // pull-in is over, PWM ISRs take over
+            }
+            else
+            {
+                if (pullInRemaining[index])
+                {
+                    pullInRemaining[index]--;
+                }
+                setOutputPort(index);       // if watchdog is running and output is set to ON switch the referring port ON
+            }
         }
         else
         {
             clearOutputPort(index);     // if watchdog is not running or output is set to OFF switch the referring port OFF
+            pullInRemaining[index] = outputProfiles[index].pullInTime;
+        }
+    }
+
+    sequencePullIns = 0;
+
+    // interrupts are disabled, so the PWM ISRs see the new masks only after the ports have been written
+    heldPortMask[ePORT_B] = held[ePORT_B];
+    heldPortMask[ePORT_C] = held[ePORT_C];
+    heldPortMask[ePORT_D] = held[ePORT_D];
+}
+
+
+// toggle the phase of each pulsed output when its pulse period is over
+static inline void handlePulses(void)
+{
+    for (uint8_t index = 0; index < eSUPPORTED_OUTPUTS; index++)
+    {
+        if (!--pulseTimers[index])
+        {
+            pulseTimers[index] = pulsePeriods[index];
+            pulseHighOutputs ^= (1 << index);
+        }
+    }
+}
+
+
+// execute the output sequence, as long as the watchdog isn't running outputs are switched OFF anyway, so the sequence is aborted
+static inline void handleSequence(void)
+{
+    if (sequence.state == eSEQUENCE_RUNNING)
+    {
+        if (!watchdog_running())
+        {
+            // don't switch the outputs ON again when the watchdog is running again
+            for (uint8_t index = 0; index < eSUPPORTED_OUTPUTS; index++)
+            {
+                if (sequence.usedOutputs & (1 << index))
+                {
+                    outputs[index] = false;
+                    timedOutputs[index].remaining = 0;
+                }
+            }
+            sequence.state = eSEQUENCE_ABORTED;
+        }
+        else if (!sequence.remaining || !--sequence.remaining)
+        {
+            if (sequence.nextStep < sequence.steps)
+            {
+                // start next step
+                const sequenceStep_t *step = &sequenceSteps[sequence.nextStep++];
+                for (uint8_t index = 0; index < eSUPPORTED_OUTPUTS; index++)
+                {
+                    if (step->mask & (1 << index))
+                    {
+                        outputs[index] = ((step->values & (1 << index)) != 0);
+                        timedOutputs[index].remaining = 0;
+                    }
+                }
+                sequencePullIns = step->mask & step->values;
+                sequence.usedOutputs |= step->mask;
+                sequence.remaining = step->duration;
+            }
+            else
+            {
+                sequence.state = eSEQUENCE_FINISHED;
+            }
+        }
+    }
+}
+
+
+// revert timed outputs when their time is over, called after handleOutputs() so an output is switched for exactly the given ticks,
+// the time doesn't run while the output is waiting for the pull-in schedule, otherwise a short ON time could pass without any pull-in
+static inline void handleTimedOutputs(void)
+{
+    for (uint8_t index = 0; index < eSUPPORTED_OUTPUTS; index++)
+    {
+        timedOutput_t *timedOutput = &timedOutputs[index];
+        bool scheduled = outputs[index] && watchdog_running() && !(drivenOutputs & (1 << index));
+        if (timedOutput->remaining && !scheduled && !--timedOutput->remaining)
+        {
+            outputs[index] = timedOutput->revertValue;
+        }
+    }
+}
+
+
+// count the ON samples of a majority filter history
+static inline uint8_t countSamples(uint8_t history)
+{
+    static const uint8_t nibbleBits[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+    return nibbleBits[history & 0x0F] + nibbleBits[history >> 4];
+}
+
+
+// filter a sampled input value, runs in constant time for each filter mode
+static inline bool filterInput(inputFilter_t *filter, bool state, bool sample)
+{
+    switch (filter->mode)
+    {
+        case eINPUT_FILTER_CONSECUTIVE:
+            // count samples different from current state, any sample equal to it restarts counting
+            if (sample == state)
+            {
+                filter->counter = 0;
+            }
+            else if (++filter->counter >= (sample ? filter->rise : filter->fall))
+            {
+                filter->counter = 0;
+                state = sample;
+            }
+            break;
+
+        case eINPUT_FILTER_MAJORITY:
+        {
+            filter->history = (filter->history << 1) | (sample ? 1 : 0);
+            uint8_t onSamples = countSamples(filter->history);
+            if (!state && (onSamples >= filter->rise))
+            {
+                state = true;
+            }
+            else if (state && ((eINPUT_FILTER_MAJORITY_WINDOW - onSamples) >= filter->fall))
+            {
+                state = false;
+            }
+            break;
+        }
+
+        case eINPUT_FILTER_INTEGRATOR:
+            // samples different from current state count up, samples equal to it count down
+            if (sample != state)
+            {
+                if (++filter->counter >= (sample ? filter->rise : filter->fall))
+                {
+                    filter->counter = 0;
+                    state = sample;
+                }
+            }
+            else if (filter->counter)
+            {
+                filter->counter--;
+            }
+            break;
+
+        default:
+            state = sample;
+            break;
+    }
+    return state;
+}
+
+
+// finish the gate time of all enabled pulse counters
+static inline void handleCounters(void)
+{
+    for (uint8_t index = 0; index < eSUPPORTED_INPUTS; index++)
+    {
+        pulseCounter_t *counter = &pulseCounters[index];
+        if (counter->gateTime && !--counter->gateRemaining)
+        {
+            counter->gateCount     = counter->count - counter->gateStart;
+            counter->gateStart     = counter->count;
+            counter->gateRemaining = counter->gateTime;
+            counter->gateValid     = true;
         }
     }
 }
@@ -291,103 +1454,160 @@ static inline void handleOutputs(void)
 
 static inline void handleInputs(void)
 {
-    // read input
+    // read all ports containing inputs only once, so all inputs are sampled at the same time
+    uint8_t pins[ePORTS] = { 0, 0, 0 };
+    if (inputPortMask[ePORT_B])
+    {
+        pins[ePORT_B] = PINB;
+    }
+    if (inputPortMask[ePORT_C])
+    {
+        pins[ePORT_C] = PINC;
+    }
+    if (inputPortMask[ePORT_D])
+    {
+        pins[ePORT_D] = PIND;
+    }
+
+    static bool    firstSample = true;
+    static uint8_t lastInputs;
+    uint8_t newInputs = 0;
     for (uint8_t index = 0; index < eSUPPORTED_INPUTS; index++)
     {
-        inputs[index] = getInputPort(index);
+        bool sample = ((pins[inputPins[index].port] & inputPins[index].mask) != 0);
+        inputs[index] = (index == eWATCHDOG_TEST_READBACK) ? sample : filterInput(&inputFilters[index], inputs[index], sample);     // watchdog test needs the real readback state
+        if (inputs[index])
+        {
+            newInputs |= (1 << index);
+        }
+    }
+
+    // record input changes (the state at startup is no change)
+    if ((newInputs != lastInputs) && !firstSample)
+    {
+        inputEvent_t *event = &inputEvents[nextEventSequence & (eINPUT_EVENTS - 1)];
+        event->sequence = nextEventSequence++;
+        event->inputs   = newInputs;
+        event->ticks    = timer_getTicks();
     }
+    lastInputs  = newInputs;
+    firstSample = false;
 }
 
 
 /**
- * @brief Retriggers the watchdog output for arround 300us at a very high frequency to bring it (back) to ON state as fast as possible
+ * @brief Executes one step of the repeated watchdog test, has to be called once per tick as long as it returns eSTOP_AND_RETRIGGER_STOPPING or eSTOP_AND_RETRIGGER_RETRIGGERING
+ * While stopping the caller must not trigger the watchdog output until the readback has been seen OFF, afterwards the watchdog output is retriggered
+ * for arround 200us per tick at a very high frequency to bring it (back) to ON state as fast as possible, so all other cyclic tasks can still be executed
+ *
+ * @return eSTOP_AND_RETRIGGER_STOPPING         waiting for readback to become OFF, watchdog output must not be triggered
+ * @return eSTOP_AND_RETRIGGER_RETRIGGERING     readback was OFF, watchdog output is retriggered until readback is ON again
+ * @return eSTOP_AND_RETRIGGER_PASSED           test finished successfully
+ * @return eSTOP_AND_RETRIGGER_STOP_FAILED      readback didn't become OFF within time
+ * @return eSTOP_AND_RETRIGGER_RETRIGGER_FAILED readback didn't become ON again within time
  */
 uint8_t ioHandler_watchdogStopAndRetrigger(void)
 {
     #if WATCHDOG_OUTPUT != D6
     #   error WATCHDOG_OUTPUT must be D6, if watchdog output has been changed the following code has to be checked!
     #endif
+    static_assert(pinToPort(WATCHDOG_OUTPUT) == ePORT_D, "fast retrigger expects watchdog output at PORTD");
 
-    debug_pin2(HIGH);
-    // prepare port values
-    uint8_t portOn  = PORTD | (1 << WATCHDOG_OUTPUT);    // if watchdog output has been changed ensure that a shift with the referring define really works!!!
-    uint8_t portOff = PORTD & ~(1 << WATCHDOG_OUTPUT);   // if watchdog output has been changed ensure that a shift with the referring define really works!!!
+    enum
+    {
+        eSTOP_TIMEOUT          = 10000 / eTICK_TIME,    // 10 seconds for high -> low
+        eRETRIGGER_TIMEOUT     = 10000 / eTICK_TIME,    // 10 seconds for low -> high
+        eSTOP_LOW_COUNT        = 5,                     // want to see low level in 5 ticks in a row since a single occurrence could be an EMC interference
+        eRETRIGGER_HIGH_COUNT  = 500,                   // even if high level has been seen again don't stop fast triggering just to ensure the relay stays active when the normal 1ms trigger period is reactivated!
+        eRETRIGGER_BURST_LOOPS = 100,                   // fast retrigger loops per tick, arround 200us
+    };
 
-    uint16_t timeoutCounter = 10000;        // 10 seconds for high -> low
-    static uint8_t lowCounter = 5;
+    static uint8_t  testPhase      = eSTOP_AND_RETRIGGER_STOPPING;
+    static uint16_t timeoutCounter = eSTOP_TIMEOUT;
+    static uint16_t stateCounter   = eSTOP_LOW_COUNT;
 
-    // want to see low level lowCounter times sice a single occurrence could be an EMC interference
-    while (lowCounter-- && timeoutCounter)
+    uint8_t result = testPhase;
+
+    debug_pin2(HIGH);
+    if (testPhase == eSTOP_AND_RETRIGGER_STOPPING)
     {
-        while(getInputPort(eWATCHDOG_TEST_READBACK) && timeoutCounter)
+        if (getInputPort(eWATCHDOG_TEST_READBACK))
         {
-            // timer interrupt (1ms) occurred?
-            if (timer_interruptSet())
-            {
-                timeoutCounter--;
-                timer_interruptClear();
-            }
+            stateCounter = eSTOP_LOW_COUNT;
+        }
+        else if (!--stateCounter)
+        {
+            // readback is OFF, start retriggering with next tick
+            testPhase      = eSTOP_AND_RETRIGGER_RETRIGGERING;
+            timeoutCounter = eRETRIGGER_TIMEOUT;
+            stateCounter   = eRETRIGGER_HIGH_COUNT;
         }
-    }
-    debug_pin2(LOW);
 
-    if (!timeoutCounter)
-    {
-        // timeout occurred
-        return eSTOP_AND_RETRIGGER_STOP_FAILED;
+        if ((testPhase == eSTOP_AND_RETRIGGER_STOPPING) && !--timeoutCounter)
+        {
+            // timeout occurred
+            result = eSTOP_AND_RETRIGGER_STOP_FAILED;
+        }
     }
+    else
+    {
+        // prepare port values
+        uint8_t portOn  = PORTD | pinToMask(WATCHDOG_OUTPUT);
+        uint8_t portOff = PORTD & ~pinToMask(WATCHDOG_OUTPUT);
 
-    timeoutCounter = 10000;              // 10 seconds for high -> low
-    static uint16_t highCounter = 500;   // even if high level has been seen again don't stop fast triggering just to ensure the relay stays active when the normal 1ms trigger period is reactivated!
-
-    debug_pin2(HIGH);
-    // want to see high level highCounter times sice a single occurrence could be an EMC interference
-    while (highCounter && timeoutCounter)
-    {
-        // retrigger relay as fast as possible
-        PORTD = portOff;
-        PORTD = portOn;
-        PORTD = portOff;
-        PORTD = portOn;
-        PORTD = portOff;
-        PORTD = portOn;
-        PORTD = portOff;
-        PORTD = portOn;
-        PORTD = portOff;
-        PORTD = portOn;
-        PORTD = portOff;
-        PORTD = portOn;
-        PORTD = portOff;
-        PORTD = portOn;
-        PORTD = portOff;
-        PORTD = portOn;
-        PORTD = portOff;
-        PORTD = portOn;
-        PORTD = portOff;
-        PORTD = portOn;
-
-        if (timer_interruptSet())
-        {
-            // timer interrupt (1ms) occurred, so decrement counter
-            timeoutCounter--;
-            timer_interruptClear();
+        // want to see high level stateCounter times sice a single occurrence could be an EMC interference
+        for (uint8_t loops = eRETRIGGER_BURST_LOOPS; loops && stateCounter; loops--)
+        {
+            // retrigger relay as fast as possible
+            PORTD = portOff;
+            PORTD = portOn;
+            PORTD = portOff;
+            PORTD = portOn;
+            PORTD = portOff;
+            PORTD = portOn;
+            PORTD = portOff;
+            PORTD = portOn;
+            PORTD = portOff;
+            PORTD = portOn;
+            PORTD = portOff;
+            PORTD = portOn;
+            PORTD = portOff;
+            PORTD = portOn;
+            PORTD = portOff;
+            PORTD = portOn;
+            PORTD = portOff;
+            PORTD = portOn;
+            PORTD = portOff;
+            PORTD = portOn;
+
+            if (getInputPort(eWATCHDOG_TEST_READBACK))
+            {
+                // correct state seen once, so decrement counter
+                stateCounter--;
+            }
         }
 
-        if (getInputPort(eWATCHDOG_TEST_READBACK))
+        if (!stateCounter)
         {
-            // correct state seen once, so decrement counter
-            highCounter--;
+            result = eSTOP_AND_RETRIGGER_PASSED;
+        }
+        else if (!--timeoutCounter)
+        {
+            // timeout occurred
+            result = eSTOP_AND_RETRIGGER_RETRIGGER_FAILED;
         }
     }
     debug_pin2(LOW);
 
-    if (!timeoutCounter)
+    if ((result != eSTOP_AND_RETRIGGER_STOPPING) && (result != eSTOP_AND_RETRIGGER_RETRIGGERING))
     {
-        // timeout occurred
-        return eSTOP_AND_RETRIGGER_RETRIGGER_FAILED;
+        // test finished, prepare everything for the next one
+        testPhase      = eSTOP_AND_RETRIGGER_STOPPING;
+        timeoutCounter = eSTOP_TIMEOUT;
+        stateCounter   = eSTOP_LOW_COUNT;
     }
 
-    return eSTOP_AND_RETRIGGER_PASSED;
+    return result;
 }
 
 
@@ -405,15 +1625,30 @@ void ioHandler_cyclicTask()
     // lock or unlock reset pin
     handleResetLock();
 
+    // execute output sequence
+    handleSequence();
+
+    // pulse phases of the pulsed outputs
+    handlePulses();
+
     // set outputs periodically so handler can toggle it!
     handleOutputs();
 
+    // revert timed outputs (with the next tick)
+    handleTimedOutputs();
+
     // read inputs
     handleInputs();
 
+    // frequency measurement of pulse counters
+    handleCounters();
+
     // handle status LED
     handleLed();
 
+    // write all outputs, the watchdog and the LED with a single access per port
+    writePorts();
+
     debug_pin3(LOW);
 }
 
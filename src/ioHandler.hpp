@@ -2,6 +2,10 @@
 #define IO_HANDLER_H
 
 
+#include <stdint.h>
+#include "timer.hpp"
+
+
 #define SUPPORTED_OUTPUTS 7
 #define SUPPORTED_INPUTS  4
 
@@ -29,8 +33,113 @@ enum
 {
     eSUPPORTED_OUTPUTS = SUPPORTED_OUTPUTS,     // watchdog is not an output, so there are only 7 of them!
     eSUPPORTED_INPUTS  = SUPPORTED_INPUTS,      // 4 inputs are available!
+
+    eALL_OUTPUTS_MASK  = (1 << SUPPORTED_OUTPUTS) - 1,  // bit mask containing all outputs
+};
+
+
+// pulsed outputs are toggled every pulse period (in ticks) instead of being switched ON, the configuration is stored in EEPROM
+enum
+{
+    ePULSED_OUTPUTS_DEFAULT = 0x07,     // outputs 0..2 are pulsed, 3..6 are not pulsed (the 4xUNPULSED board variant)
+    ePULSE_PERIOD_DEFAULT   = 1,        // toggle with each tick
+    eMAX_PULSE_PERIOD       = 100,
+};
+
+
+// input filters, each input except the watchdog readback can be filtered, rise and fall are given in ticks (samples)
+enum
+{
+    eINPUT_FILTER_NONE = 0,             // sampled value is used directly (default)
+    eINPUT_FILTER_CONSECUTIVE = 1,      // input changes after rise (fall) consecutive samples with the new state
+    eINPUT_FILTER_MAJORITY = 2,         // input changes when rise (fall) of the last eINPUT_FILTER_MAJORITY_WINDOW samples have the new state
+    eINPUT_FILTER_INTEGRATOR = 3,       // counter is incremented with each new state sample and decremented with each old state sample, input changes when rise (fall) is reached
+    eINPUT_FILTERS,
+
+    eINPUT_FILTER_MAJORITY_WINDOW = 8,  // number of samples a majority vote is done on
+};
+
+
+// input change events, each change of the sampled inputs is recorded with a sequence number in a ring of eINPUT_EVENTS entries
+enum
+{
+    eINPUT_EVENTS = 16,             // has to be a power of two
+};
+
+typedef struct
+{
+    uint16_t sequence;              // incremented with each event
+    uint8_t  inputs;                // input states after the change (bit 0 = input 0)
+    uint32_t ticks;                 // tick the change has been detected
+} inputEvent_t;
+
+
+// input edges captured by pin change interrupt, stored in a ring of eINPUT_EDGES entries until they are removed
+enum
+{
+    eINPUT_EDGES = 32,              // has to be a power of two
+};
+
+typedef struct
+{
+    uint32_t ticks;                 // tick of the edge
+    uint8_t  counts;                // timer counts (eTIMER_COUNT_TIME us each) since the tick
+    uint8_t  inputs;                // input states after the edge (bit 0 = input 0)
+} inputEdge_t;
+
+
+// output drive profiles, after the pull-in time a not pulsed output is held with a PWM duty cycle to reduce the coil current
+enum
+{
+    eMAX_PULL_IN_TIME = 10000 / eTICK_TIME,     // longest pull-in time with full drive
+    eMAX_HOLD_DUTY = 99,                        // hold duty in percent, all held outputs share the same duty
+};
+
+
+// staggered switching, limits the outputs switched ON within a gap to reduce the inrush current (switching OFF is never delayed)
+enum
+{
+    eMAX_PULL_IN_GAP = 10000 / eTICK_TIME,      // longest gap between staggered pull-ins
+};
+
+
+// output sequence, up to eSEQUENCE_STEPS steps are executed one after the other by the cyclic task
+enum
+{
+    eSEQUENCE_STEPS = 8,
+};
+
+// sequence states
+enum
+{
+    eSEQUENCE_IDLE = 0,             // not started or stopped
+    eSEQUENCE_RUNNING = 1,
+    eSEQUENCE_FINISHED = 2,         // all steps have been executed, outputs keep the states of the last step
+    eSEQUENCE_ABORTED = 3,          // watchdog stopped running, all outputs used by the sequence have been switched OFF
+};
+
+typedef struct
+{
+    uint8_t  mask;                  // outputs changed by the step (bit 0 = output 0)
+    uint8_t  values;                // new states of the changed outputs
+    uint16_t duration;              // ticks until the next step starts
+} sequenceStep_t;
+
+
+// pulse counters, input 1 is counted by external interrupt INT1 and inputs 2 and 3 by pin change interrupt (rising edges only)
+enum
+{
+    eMAX_GATE_TIME = 60000 / eTICK_TIME,        // longest gate time for the frequency measurement
 };
 
+typedef struct
+{
+    uint32_t count;                 // rising edges since the counter has been enabled
+    uint32_t gateCount;             // rising edges within the last complete gate time
+    uint32_t frequency;             // frequency in mHz calculated from gateCount, 0 until the first gate time has elapsed
+    uint16_t gateTime;              // gate time in ticks, 0 = counter disabled
+} inputCounter_t;
+
 
 // return values of ioHandler_watchdogStopAndRetrigger()
 enum
@@ -38,6 +147,8 @@ enum
     eSTOP_AND_RETRIGGER_PASSED = 0,
     eSTOP_AND_RETRIGGER_STOP_FAILED = 1,
     eSTOP_AND_RETRIGGER_RETRIGGER_FAILED = 2,
+    eSTOP_AND_RETRIGGER_STOPPING = 3,           // test still running, watchdog output has to stay OFF
+    eSTOP_AND_RETRIGGER_RETRIGGERING = 4,       // test still running, watchdog output is retriggered
 };
 
 
@@ -46,6 +157,35 @@ void ioHandler_setup(void);
 void ioHandler_setOutput(uint16_t index, uint8_t value);
 bool ioHandler_getOutput(uint16_t index);
 bool ioHandler_getInput(uint16_t index);
+void ioHandler_setOutputs(uint8_t mask, uint8_t values);
+uint8_t ioHandler_getOutputs(void);
+uint8_t ioHandler_getInputs(void);
+void ioHandler_setInputFilter(uint8_t index, uint8_t mode, uint8_t rise, uint8_t fall);
+void ioHandler_enableEdgeCapture(bool enable);
+uint8_t ioHandler_getEdgeCount(void);
+bool ioHandler_getEdge(uint8_t index, inputEdge_t *edge);
+void ioHandler_removeEdges(uint8_t count);
+uint16_t ioHandler_getLostEdges(void);
+void ioHandler_setTimedOutput(uint16_t index, uint8_t value, uint16_t duration);
+uint16_t ioHandler_getTimedOutput(uint16_t index, bool *revertValue);
+bool ioHandler_setSequenceStep(uint8_t index, const sequenceStep_t *step);
+void ioHandler_getSequenceStep(uint8_t index, sequenceStep_t *step);
+void ioHandler_startSequence(uint8_t steps);
+void ioHandler_stopSequence(void);
+uint8_t ioHandler_getSequenceState(uint8_t *step, uint16_t *remaining);
+bool ioHandler_sequenceFitsSchedule(uint8_t steps);
+void ioHandler_setPullInSchedule(uint8_t maxPullIns, uint16_t gap);
+uint16_t ioHandler_getPullInDelay(void);
+bool ioHandler_holdSupported(uint8_t index);
+bool ioHandler_holdDutyAvailable(uint8_t index, uint8_t duty);
+bool ioHandler_setOutputConfig(uint8_t index, bool pulsed, uint8_t pulsePeriod);
+bool ioHandler_getOutputConfig(uint8_t index, uint8_t *pulsePeriod);
+void ioHandler_setOutputProfile(uint8_t index, uint16_t pullInTime, uint8_t holdDuty);
+bool ioHandler_counterSupported(uint8_t index);
+void ioHandler_setCounter(uint8_t index, uint16_t gateTime);
+void ioHandler_getCounter(uint8_t index, inputCounter_t *counter);
+uint16_t ioHandler_getNextEventSequence(void);
+bool ioHandler_getEvent(uint16_t sequence, inputEvent_t *event);
 
 uint8_t ioHandler_watchdogStopAndRetrigger(void);
 
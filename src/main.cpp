@@ -2,10 +2,17 @@
 #include "ioHandler.hpp"
 #include "timer.hpp"
 #include "messageHandler.hpp"
+#include "uart.hpp"
+#include "config.hpp"
+#include "history.hpp"
+#include "stackMonitor.hpp"
 
 
 void setup() {
-    Serial.begin(9600);
+    stackMonitor_setup();
+    config_setup();
+    history_setup();
+    uart_setup((uint32_t)config_getParameter(eCONFIG_BAUD_RATE) * eUART_BAUD_RATE_UNIT);
     debug_setup();
     ioHandler_setup();
     timer_setup();
@@ -13,9 +20,8 @@ void setup() {
 
 
 void loop() {
-    if (Serial.available() > 0)
-    {
-        messageHandler_receivedChar(Serial.read());
-    }
+    timer_idle();
+    stackMonitor_check();
+    messageHandler_cyclicTask();
 }
 
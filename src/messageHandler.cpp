@@ -1,5 +1,6 @@
 #include <Arduino.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include "debug.hpp"
@@ -7,8 +8,13 @@
 #include "crc16X25.hpp"
 #include "ioHandler.hpp"
 #include "watchdog.hpp"
+#include "config.hpp"
+#include "history.hpp"
 #include "version.hpp"
 #include "errorAndDiagnosis.hpp"
+#include "uart.hpp"
+#include "timer.hpp"
+#include "stackMonitor.hpp"
 
 #define MAGIC {'M','H','S','W','M','H','S','W'}     // 4D4853574D485357
 
@@ -24,28 +30,191 @@ enum
     eMESSAGE_ERROR_INVALID_CRC = 7,
     eMESSAGE_ERROR_OVERFLOW = 8,
     eMESSAGE_ERROR_INVALID_STARTUP = 9,             // before watchdog can be set version has to be requested!
+    eMESSAGE_ERROR_BUSY = 10,                       // request can't be executed in the current state (e.g. sequence is running)
+
+    eMESSAGE_ERRORS,                                // number of error numbers including eMESSAGE_ERROR_NONE
 };
 
-// request/response transmit definitions
-#define MAX_REQUEST_LENGTH  (20)
-#define MAX_RESPONSE_LENGTH (3 * (MAX_REQUEST_LENGTH))
+// request receive definitions (requests are parsed while they are received, responses are written directly into the UART TX ring)
+#define MAX_VERSION_LENGTH  (20)
 enum
 {
-    eMAX_REQUEST_LENGTH = MAX_REQUEST_LENGTH,
-    eMAX_RESPONSE_LENGTH = MAX_RESPONSE_LENGTH,
+    eMAX_REQUEST_ECHO_LENGTH = 20,      // first characters of a request that will be responded in case of an error
+    eMAX_REQUEST_LENGTH = 255,          // longer requests are rejected with eMESSAGE_ERROR_OVERFLOW
+    eMAX_PARAMETERS = 4,                // maximum number of parameters between command and CRC
 };
-char request[eMAX_REQUEST_LENGTH + 1] = "";
-uint16_t requestIndex = 0;
-char response[eMAX_RESPONSE_LENGTH + 2] = "";
+static char request[eMAX_REQUEST_ECHO_LENGTH + 1] = "";     // bounded copy of the current request to be responded in case of an error
 static bool versionReadCommandReceived;         // before any 'W' commands are accepted the version has to be read with 'V'!
+static uint16_t nextExpectedFrameNumber = 0;    // frame number of the next request, also sent with NACKs and event frames
+
+// input change events are sent unsolicited when enabled, they don't use a frame number on their own
+static bool     eventsEnabled;
+static uint16_t nextEventToSend;                // sequence number of the next event to be sent
+
+// transfer modes, ASCII is the default mode, the binary mode uses COBS encoded frames "<fno><cmd><payload><crc>" with fixed width payloads
+enum
+{
+    eTRANSFER_MODE_ASCII  = 0,
+    eTRANSFER_MODE_BINARY = 1,
+};
+static uint8_t transferMode = eTRANSFER_MODE_ASCII;             // mode used for current request and response
+static uint8_t requestedTransferMode = eTRANSFER_MODE_ASCII;    // mode to be used after current response has been sent
+
+// captured input edges sent with a single response
+enum
+{
+    eEDGES_PER_RESPONSE = 4,
+};
+
+// link and protocol statistics, all counters saturate instead of wrapping around
+enum
+{
+    eSTATISTICS_PAGE_LINK     = 0,
+    eSTATISTICS_PAGE_NACKS    = 1,
+    eSTATISTICS_PAGE_TIMING   = 2,
+    eSTATISTICS_PAGE_MEMORY   = 3,
+    eSTATISTICS_PAGE_COMMANDS = 4,      // first page of the per command execution counters
+    eCOMMANDS_PER_STATISTICS_PAGE = 8,
+};
+static struct
+{
+    uint32_t receivedFrames;            // complete requests including damaged ones
+    uint32_t sentFrames;                // responses, NACKs and events
+    uint16_t replayedResponses;         // retransmitted requests answered from the response cache
+    uint16_t droppedRequests;           // requests in flight dropped after a NACK
+    uint16_t discardedBytes;            // bytes ignored behind the first error of a request
+    uint16_t nacks[eMESSAGE_ERRORS];    // NACKs per error number
+} statistics;
+
+static inline void countUp(uint16_t *counter)
+{
+    if (*counter != 0xFFFF)
+    {
+        (*counter)++;
+    }
+}
+
+static inline void countUp(uint32_t *counter)
+{
+    if (*counter != 0xFFFFFFFF)
+    {
+        (*counter)++;
+    }
+}
+
+// history entries sent with a single response
+enum
+{
+    eHISTORY_PER_RESPONSE = 3,
+};
+
+// pipelining, the host may send up to windowSize requests without waiting for their responses, they are processed in order
+enum
+{
+    eMAX_WINDOW_SIZE = 8,                   // all requests in flight have to fit into the UART RX ring
+};
+static uint8_t windowSize = 1;              // 1 = lock-step (default)
+static bool    resynchronizing;             // a NACK has been sent, requests in flight behind the missing one are dropped silently
+
+// request latencies in timer_getStamp() units, log2 histograms of the queueing delay (line end or frame delimiter received until the
+// request is processed) and of the service time (until the last response byte has left the UART) of all requests and of one command
+enum
+{
+    eLATENCY_BUCKETS = 8,
+    eQUEUEING_BUCKET_SHIFT = 1,             // first queueing bucket is below 2 stamps (32us), each further one doubles, the last one is open
+    eSERVICE_BUCKET_SHIFT  = 5,             // first service bucket is below 32 stamps (512us), each further one doubles, the last one is open
+    eLATENCY_ALL_REQUESTS  = 0,             // selection of the histograms of all requests
+};
+typedef struct
+{
+    uint16_t queueing[eLATENCY_BUCKETS];
+    uint16_t service[eLATENCY_BUCKETS];
+} latencyHistograms_t;
+static latencyHistograms_t allLatencies;
+static latencyHistograms_t commandLatencies;
+static char latencyCommand;                 // command whose latencies are collected in commandLatencies, 0 = none selected so far
+
+// responses whose last byte hasn't left the UART so far (in sending order), their service time is taken when it has
+static struct
+{
+    uint16_t position;                      // uart_transmitPosition() behind the response
+    uint16_t receiveStamp;                  // request's line end or frame delimiter has been received
+    bool     selected;                      // response to latencyCommand
+} sendingResponses[eMAX_WINDOW_SIZE];
+static uint8_t sendingHead;
+static uint8_t sendingCount;
+static bool    responded;                   // a response has been finished for the current request
+
+// log2 bucket of a latency that has already been shifted by the first bucket's size
+static uint8_t latencyBucket(uint16_t latency)
+{
+    uint8_t bucket = 0;
+    while (latency && (bucket < eLATENCY_BUCKETS - 1))
+    {
+        latency >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static void clearLatencies(latencyHistograms_t *histograms)
+{
+    for (uint8_t bucket = 0; bucket < eLATENCY_BUCKETS; bucket++)
+    {
+        histograms->queueing[bucket] = histograms->service[bucket] = 0;
+    }
+}
+
+// collect the command histograms for another command, responses of the previous one still being sent don't count anymore
+static void selectLatencyCommand(char command)
+{
+    latencyCommand = command;
+    clearLatencies(&commandLatencies);
+    for (uint8_t entry = 0; entry < eMAX_WINDOW_SIZE; entry++)
+    {
+        sendingResponses[entry].selected = false;
+    }
+}
+
+// supported baud rates in eBAUD_RATE_UNIT steps, the configured one (eCONFIG_BAUD_RATE) is the startup and fallback baud rate
+enum
+{
+    eBAUD_RATE_UNIT = eUART_BAUD_RATE_UNIT,
+    eBAUD_RATE_CONFIRMATION_TIMEOUT = 2000 / eTICK_TIME,    // time to receive a valid request with the new baud rate before falling back to default baud rate
+};
+static const uint16_t supportedBaudRates[] = { eUART_BAUD_RATE_DEFAULT / eBAUD_RATE_UNIT, 576, 1152, 2500, 5000, 10000 };
+
+enum
+{
+    eBAUD_RATE_CONFIRMED,           // current baud rate is in use and confirmed
+    eBAUD_RATE_SWITCH_PENDING,      // new baud rate has been requested and will be set as soon as the response has been sent completely
+    eBAUD_RATE_UNCONFIRMED,         // new baud rate has been set but no valid request has been received so far
+};
+static uint8_t  baudRateState = eBAUD_RATE_CONFIRMED;
+static uint16_t requestedBaudRate;                  // baud rate to switch to in eBAUD_RATE_UNIT steps
+static uint32_t baudRateSwitchTicks;                // tick when baud rate has been switched
+
+// check if given baud rate (in eBAUD_RATE_UNIT steps) is supported
+static bool baudRateSupported(uint16_t baudRate)
+{
+    bool supported = false;
+    for (uint8_t rateIndex = 0; rateIndex < sizeof(supportedBaudRates) / sizeof(supportedBaudRates[0]); rateIndex++)
+    {
+        if (baudRate == supportedBaudRates[rateIndex])
+        {
+            supported = true;
+        }
+    }
+    return supported;
+}
 
 // version information
-#if MAX_REQUEST_LENGTH != 20
-#   error MAX_REQUEST_LENGTH has to be 20 to avoid buffer overflow in answer string!!!
+#if MAX_VERSION_LENGTH != 20
+#   error MAX_VERSION_LENGTH has to be 20 to avoid buffer overflow in answer string!!!
 #endif
 static const struct __attribute__((packed)) {
     char leadIn[8];
-    char version[MAX_REQUEST_LENGTH];
+    char version[MAX_VERSION_LENGTH];
     char leadOut[8];
 } VERSION_FIELD = {
     MAGIC,
@@ -59,27 +228,134 @@ static const struct __attribute__((packed)) {
     MAGIC
 };
 
-// put a semicolon and a string end character to the given string to prepare string for next token
-static inline uint16_t finalizeToken(char *string, uint16_t index)
+// CRC of the response currently sent, every sent character is added
+static uint16_t responseCrc;
+static uint8_t  cobsCodePosition;       // binary mode only: TX ring position of the code byte of the current COBS block
+static uint8_t  cobsCode;               // binary mode only: code of the current COBS block (number of bytes in the block + 1)
+
+// nothing behind a reserved code byte is sent before the block is finished, so a COBS block has to fit into the TX ring, otherwise
+// uart_transmit() would wait forever, binary responses are far shorter than the ring (the longest one is 'h' with 44 bytes)
+enum
+{
+    eMAX_BINARY_RESPONSE_LENGTH = 48,                   // fno, cmd, payload and CRC of the longest binary response
+    eMAX_COBS_BLOCK = eUART_TX_BUFFER_SIZE - 1,         // code byte and data of a block that fit into the TX ring (one position stays free)
+};
+static_assert(eMAX_BINARY_RESPONSE_LENGTH + 1 <= eMAX_COBS_BLOCK, "binary responses have to fit into the TX ring as a single COBS block");
+
+// responses of the last executed requests, a retransmitted request gets its cached response again instead of being executed twice
+enum
+{
+    eRESPONSE_CACHE_ENTRIES = 4,
+    eRESPONSE_CACHE_LENGTH = 48,        // longer responses are not cached
+};
+typedef struct
+{
+    uint16_t frameNumber;               // frame number and CRC of the request as they have been received
+    uint16_t requestCrc;
+    uint8_t  transferMode;              // transfer mode of request and response
+    uint8_t  length;                    // number of cached response characters, 0 = unused entry
+    char     response[eRESPONSE_CACHE_LENGTH];      // response characters behind the frame number without CRC and framing
+} cachedResponse_t;
+static cachedResponse_t responseCache[eRESPONSE_CACHE_ENTRIES];
+static uint8_t nextCacheEntry;                      // oldest entry that will be overwritten next
+static cachedResponse_t *cachingEntry;              // entry the current response is written to, NULL if current response isn't cached
+
+// binary mode only: start a new COBS block by reserving its code byte
+static inline void startCobsBlock(void)
+{
+    cobsCodePosition = uart_reserve();
+    cobsCode = 1;
+}
+
+// binary mode only: finish current COBS block by setting its code byte
+static inline void finishCobsBlock(void)
+{
+    uart_patch(cobsCodePosition, cobsCode);
+}
+
+// send a single byte, in binary mode it's COBS encoded
+static void sendByte(char byte)
+{
+    if (transferMode == eTRANSFER_MODE_BINARY)
+    {
+        if (byte == '\0')
+        {
+            // zeros are not sent but given by the code byte of the current block
+            finishCobsBlock();
+            startCobsBlock();
+        }
+        else if (cobsCode >= eMAX_COBS_BLOCK)
+        {
+            // block doesn't fit into the TX ring anymore, the rest is dropped instead of blocking forever (the host sees a CRC error)
+        }
+        else
+        {
+            uart_transmit(byte);
+            if (++cobsCode == 0xFF)
+            {
+                // maximum block length reached
+                finishCobsBlock();
+                startCobsBlock();
+            }
+        }
+    }
+    else
+    {
+        uart_transmit(byte);
+    }
+}
+
+// start a new response
+static inline void startResponse(void)
+{
+    responseCrc = eCRC16_X25_INIT;
+    if (transferMode == eTRANSFER_MODE_BINARY)
+    {
+        startCobsBlock();
+    }
+}
+
+// send a single response character and add it to the response CRC
+static void sendChar(char character)
 {
-    string[index++] = ';';
-    string[index] = '\0';
+    if (cachingEntry)
+    {
+        if (cachingEntry->length < eRESPONSE_CACHE_LENGTH)
+        {
+            cachingEntry->response[cachingEntry->length++] = character;
+        }
+        else
+        {
+            // response too long, drop the incomplete entry
+            cachingEntry->length = 0;
+            cachingEntry = NULL;
+        }
+    }
+    responseCrc = crc16X25Step(character, responseCrc);
+    sendByte(character);
+}
 
-    return index;
+// put a semicolon at the end of the response to prepare it for next token (binary responses have fixed width tokens without separator)
+static inline void finalizeToken(void)
+{
+    if (transferMode == eTRANSFER_MODE_ASCII)
+    {
+        sendChar(';');
+    }
 }
 
-// add an integer at the end of the string, concatenate a ';' and finally a string end character '\0'
-static uint16_t addInteger(char *string, uint16_t index, uint16_t value)
+// add an integer at the end of the response and concatenate a ';'
+static void addInteger(uint16_t value)
 {
     if (value == 0)
     {
         // necessary since algorithm cannot handle 0 value!
-        string[index++] = '0';
+        sendChar('0');
     }
     else if (value == 1)
     {
         // to speed up since a lot of values are just 1, e.g. input/output states
-        string[index++] = '1';
+        sendChar('1');
     }
     else
     {
@@ -90,44 +366,156 @@ static uint16_t addInteger(char *string, uint16_t index, uint16_t value)
             if (value >= divider || digitAdded)
             {
                 uint8_t newDigit = (uint8_t)(value / divider);
-                string[index++] = newDigit + '0';
+                sendChar(newDigit + '0');
                 value -= divider * newDigit;
                 digitAdded = true; // digit added so ensure all positions containing a '0' will also be added
             }
             else if (digitAdded)
             {
-                string[index++] = '0';
+                sendChar('0');
             }
             divider /= 10;
         }
     }
-    return finalizeToken(string, index);
+    finalizeToken();
+}
+
+// add an 8 bit value to the response, decimal in ASCII mode and a single byte in binary mode
+static void addByte(uint8_t value)
+{
+    if (transferMode == eTRANSFER_MODE_BINARY)
+    {
+        sendChar(value);
+    }
+    else
+    {
+        addInteger(value);
+    }
+}
+
+// add a 16 bit value to the response, decimal in ASCII mode and two bytes (little endian) in binary mode
+static void addWord(uint16_t value)
+{
+    if (transferMode == eTRANSFER_MODE_BINARY)
+    {
+        sendChar(value & 0xFF);
+        sendChar(value >> 8);
+    }
+    else
+    {
+        addInteger(value);
+    }
+}
+
+// add the frame number to the response, in binary mode only the lower 8 bits are sent
+static inline void addFrameNumber(uint16_t frameNumber)
+{
+    addByte((transferMode == eTRANSFER_MODE_BINARY) ? (uint8_t)frameNumber : frameNumber);
+}
+
+// add an character at the end of the response and concatenate a ';'
+static void addChar(char character)
+{
+    sendChar(character);
+    finalizeToken();
+}
+
+// add a string (only ASCII characters 0x20-0x7E)
+static void addString(const char *const concatString)
+{
+    for (uint16_t sourceIndex = 0; concatString[sourceIndex] >= '\x20' && concatString[sourceIndex] <= '\x7E'; sourceIndex++)
+    {
+        sendChar(concatString[sourceIndex]);
+    }
+}
+
+// add a 32 bit value to the response, decimal in ASCII mode and four bytes (little endian) in binary mode
+static void addLong(uint32_t value)
+{
+    if (transferMode == eTRANSFER_MODE_BINARY)
+    {
+        addWord(value & 0xFFFF);
+        addWord(value >> 16);
+    }
+    else
+    {
+        char digits[11];        // 4294967295 + '\0'
+        ultoa(value, digits, 10);
+        addString(digits);
+        finalizeToken();
+    }
+}
+
+// add a request as a single token by including it into open and closing squared brackets (ASCII mode only)
+static void addRequest(const char *const request)
+{
+    if (transferMode == eTRANSFER_MODE_ASCII)
+    {
+        sendChar('[');
+        addString(request);
+        sendChar(']');
+        finalizeToken();
+    }
+}
+
+// add the CRC of everything sent so far and finish the response with a line end (ASCII mode) or a frame delimiter (binary mode)
+static void finishResponse(void)
+{
+    cachingEntry = NULL;        // CRC and framing are not cached, they are created again when the response is replayed
+    responded = true;
+    countUp(&statistics.sentFrames);
+    uint16_t crc = crc16X25Xor(responseCrc);
+    if (transferMode == eTRANSFER_MODE_BINARY)
+    {
+        sendByte(crc & 0xFF);
+        sendByte(crc >> 8);
+        finishCobsBlock();
+        uart_transmit('\0');
+    }
+    else
+    {
+        addInteger(crc);
+        uart_transmit('\r');
+        uart_transmit('\n');
+    }
 }
 
-// add an character at the end of the string, concatenate a ';' and finally a string end character '\0'
-static uint16_t addChar(char *string, uint16_t index, char character)
+// cache the response that is started next, the oldest cached response is replaced
+static void cacheResponse(uint16_t frameNumber, uint16_t requestCrc)
 {
-    string[index++] = character;
-    return finalizeToken(string, index);
+    cachingEntry = &responseCache[nextCacheEntry];
+    nextCacheEntry = (nextCacheEntry + 1) % eRESPONSE_CACHE_ENTRIES;
+    cachingEntry->frameNumber  = frameNumber;
+    cachingEntry->requestCrc   = requestCrc;
+    cachingEntry->transferMode = transferMode;
+    cachingEntry->length       = 0;
 }
 
-// add a string (only ASCII characters 0x20-0x7E) as a single token by including it into open and closing squared brackets
-static uint16_t addString(char *string, uint16_t index, const char *const concatString)
+// find the cached response of a request that has already been executed, NULL if there is none
+static const cachedResponse_t *findCachedResponse(uint16_t frameNumber, uint16_t requestCrc)
 {
-    for (uint16_t sourceIndex = 0; concatString[sourceIndex] >= '\x20' && concatString[sourceIndex] <= '\x7E'; sourceIndex++, index++)
+    const cachedResponse_t *cachedResponse = NULL;
+    for (uint8_t index = 0; index < eRESPONSE_CACHE_ENTRIES; index++)
     {
-        string[index] = concatString[sourceIndex];
+        const cachedResponse_t *entry = &responseCache[index];
+        if (entry->length && (entry->frameNumber == frameNumber) && (entry->requestCrc == requestCrc) && (entry->transferMode == transferMode))
+        {
+            cachedResponse = entry;
+        }
     }
-    return index;
+    return cachedResponse;
 }
 
-// add a request as a single token by including it into open and closing squared brackets
-static uint16_t addRequest(char *string, uint16_t index, const char *const request)
+// send a cached response again
+static void replayResponse(const cachedResponse_t *cachedResponse)
 {
-    string[index++] = '[';
-    index = addString(string, index, request);
-    string[index++] = ']';
-    return finalizeToken(string, index);
+    startResponse();
+    addFrameNumber(cachedResponse->frameNumber);
+    for (uint8_t index = 0; index < cachedResponse->length; index++)
+    {
+        sendChar(cachedResponse->response[index]);
+    }
+    finishResponse();
 }
 
 // calculate a decimal value that is created number by number from highest to lowest
@@ -158,365 +546,1164 @@ static inline bool createDecimal(uint16_t *value, char add)
     return error;
 }
 
-// error variable for currently received request
-static uint16_t receiveError;
+enum
+{
+    eCOMMAND_WATCHDOG = 'W',        // value for "watchdog" command
+    eCOMMAND_SET_OUTPUT = 'S',      // value for "set output" command
+    eCOMMAND_READ_INPUT = 'R',      // value for "read input" command
+    eCOMMAND_GET_VERSION = 'V',     // value for "get version" command
+    eCOMMAND_EXECUTE_TEST = 'T',    // value for "execute test" command
+    eCOMMAND_GET_DIAGNOSES = 'D',   // value for "get diagnoses" command
+    eCOMMAND_SET_BAUD_RATE = 'B',   // value for "set baud rate" command
+    eCOMMAND_GET_CAPABILITIES = 'C',// value for "get capabilities" command
+    eCOMMAND_SET_TRANSFER_MODE = 'X',// value for "set transfer mode" command
+    eCOMMAND_SET_OUTPUTS = 'M',     // value for "set outputs by mask" command
+    eCOMMAND_READ_ALL = 'A',        // value for "read all inputs and outputs" command
+    eCOMMAND_HEARTBEAT = 'H',       // value for "watchdog with status" command
+    eCOMMAND_SET_WINDOW_SIZE = 'N', // value for "set window size" command
+    eCOMMAND_ENABLE_EVENTS = 'J',   // value for "enable input events" command
+    eCOMMAND_GET_EVENT = 'G',       // value for "get input event" command
+    eCOMMAND_SET_INPUT_FILTER = 'F',// value for "set input filter" command
+    eCOMMAND_ENABLE_EDGE_CAPTURE = 'K',     // value for "enable edge capture" command
+    eCOMMAND_GET_EDGES = 'Q',       // value for "get captured edges" command
+    eCOMMAND_SET_COUNTER = 'Z',     // value for "set pulse counter" command
+    eCOMMAND_GET_COUNTER = 'Y',     // value for "get pulse counter" command
+    eCOMMAND_SET_OUTPUT_PROFILE = 'L',      // value for "set output drive profile" command
+    eCOMMAND_SET_PULL_IN_SCHEDULE = 'O',    // value for "set pull-in schedule" command
+    eCOMMAND_SET_TIMED_OUTPUT = 'P',        // value for "set timed output" command
+    eCOMMAND_GET_TIMED_OUTPUT = 'p',        // value for "get timed output" command
+    eCOMMAND_SET_SEQUENCE_STEP = 'U',       // value for "set sequence step" command
+    eCOMMAND_GET_SEQUENCE_STEP = 'u',       // value for "get sequence step" command
+    eCOMMAND_RUN_SEQUENCE = 'r',            // value for "run sequence" command
+    eCOMMAND_SET_OUTPUT_CONFIG = 'o',       // value for "set output configuration" command
+    eCOMMAND_GET_OUTPUT_CONFIG = 'g',       // value for "get output configuration" command
+    eCOMMAND_GET_PARAMETER = 'c',           // value for "get configuration parameter" command
+    eCOMMAND_STAGE_PARAMETER = 's',         // value for "stage configuration parameter" command
+    eCOMMAND_WRITE_CONFIG = 'w',            // value for "commit or discard staged configuration" command
+    eCOMMAND_GET_HISTORY = 'h',             // value for "get history" command
+    eCOMMAND_GET_STATISTICS = 'd',          // value for "get statistics" command
+    eCOMMAND_GET_LATENCIES = 'l',           // value for "get request latencies" command
+    eCOMMAND_EVENT = 'I',           // value for input event (only sent, never received!)
+
+    eCOMMAND_NACK = 'E',            // value for NACK (only sent, never received!)
+};
+
+// describes the parameters of a command, all parameters are decimal values between command and CRC (ASCII mode) or 8/16 bit values (binary mode)
+typedef struct
+{
+    char    command;                // command character
+    uint8_t parameters;             // number of parameters
+    uint8_t indexParameters;        // bit mask of parameters that are an index (parsing error is eMESSAGE_ERROR_INVALID_INDEX instead of eMESSAGE_ERROR_INVALID_VALUE)
+    uint8_t wideParameters;         // bit mask of parameters that are 16 bit values in binary mode (all others are 8 bit values)
+} commandDescriptor_t;
+
+static const commandDescriptor_t commandDescriptors[] =
+{
+    { eCOMMAND_WATCHDOG,            1, 0,      0 },         // <state>
+    { eCOMMAND_SET_OUTPUT,          2, 1 << 0, 0 },         // <output>;<state>
+    { eCOMMAND_READ_INPUT,          1, 1 << 0, 0 },         // <input>
+    { eCOMMAND_GET_VERSION,         0, 0,      0 },
+    { eCOMMAND_EXECUTE_TEST,        0, 0,      0 },
+    { eCOMMAND_GET_DIAGNOSES,       0, 0,      0 },
+    { eCOMMAND_SET_BAUD_RATE,       1, 0,      1 << 0 },    // <baudRate>
+    { eCOMMAND_GET_CAPABILITIES,    0, 0,      0 },
+    { eCOMMAND_SET_TRANSFER_MODE,   1, 0,      0 },         // <mode>
+    { eCOMMAND_SET_OUTPUTS,         2, 0,      0 },         // <outputs>;<mask>
+    { eCOMMAND_READ_ALL,            0, 0,      0 },
+    { eCOMMAND_HEARTBEAT,           1, 0,      0 },         // <state>
+    { eCOMMAND_SET_WINDOW_SIZE,     1, 0,      0 },         // <windowSize>
+    { eCOMMAND_ENABLE_EVENTS,       1, 0,      0 },         // <enable>
+    { eCOMMAND_GET_EVENT,           1, 0,      1 << 0 },    // <sequence>
+    { eCOMMAND_SET_INPUT_FILTER,    4, 1 << 0, 0 },         // <input>;<mode>;<rise>;<fall>
+    { eCOMMAND_ENABLE_EDGE_CAPTURE, 1, 0,      0 },         // <enable>
+    { eCOMMAND_GET_EDGES,           1, 0,      0 },         // <remove>
+    { eCOMMAND_SET_COUNTER,         2, 1 << 0, 1 << 1 },    // <input>;<gateTime>
+    { eCOMMAND_GET_COUNTER,         1, 1 << 0, 0 },         // <input>
+    { eCOMMAND_SET_OUTPUT_PROFILE,  3, 1 << 0, 1 << 1 },    // <output>;<pullInTime>;<holdDuty>
+    { eCOMMAND_SET_PULL_IN_SCHEDULE,2, 0,      1 << 1 },    // <maxPullIns>;<gap>
+    { eCOMMAND_SET_TIMED_OUTPUT,    3, 1 << 0, 1 << 2 },    // <output>;<state>;<duration>
+    { eCOMMAND_GET_TIMED_OUTPUT,    1, 1 << 0, 0 },         // <output>
+    { eCOMMAND_SET_SEQUENCE_STEP,   4, 1 << 0, 1 << 3 },    // <step>;<mask>;<values>;<duration>
+    { eCOMMAND_GET_SEQUENCE_STEP,   1, 1 << 0, 0 },         // <step>
+    { eCOMMAND_RUN_SEQUENCE,        2, 0,      0 },         // <action>;<steps>
+    { eCOMMAND_SET_OUTPUT_CONFIG,   3, 1 << 0, 0 },         // <output>;<pulsed>;<pulsePeriod>
+    { eCOMMAND_GET_OUTPUT_CONFIG,   1, 1 << 0, 0 },         // <output>
+    { eCOMMAND_GET_PARAMETER,       1, 1 << 0, 0 },         // <parameter>
+    { eCOMMAND_STAGE_PARAMETER,     2, 1 << 0, 1 << 1 },    // <parameter>;<value>
+    { eCOMMAND_WRITE_CONFIG,        1, 0,      0 },         // <action>
+    { eCOMMAND_GET_HISTORY,         1, 0,      1 << 0 },    // <sequence>
+    { eCOMMAND_GET_STATISTICS,      2, 0,      0 },         // <page>;<reset>
+    { eCOMMAND_GET_LATENCIES,       2, 0,      0 },         // <command>;<reset>
+};
+
+enum
+{
+    eCOMMANDS = sizeof(commandDescriptors) / sizeof(commandDescriptors[0]),
+    eSTATISTICS_PAGES = eSTATISTICS_PAGE_COMMANDS + (eCOMMANDS + eCOMMANDS_PER_STATISTICS_PAGE - 1) / eCOMMANDS_PER_STATISTICS_PAGE,
+};
+static uint16_t commandCounts[eCOMMANDS];       // executed requests per command (same order as commandDescriptors)
+
+// find descriptor of given command
+static const commandDescriptor_t *findCommand(char command)
+{
+    const commandDescriptor_t *descriptor = NULL;
+    for (uint8_t index = 0; index < sizeof(commandDescriptors) / sizeof(commandDescriptors[0]); index++)
+    {
+        if (commandDescriptors[index].command == command)
+        {
+            descriptor = &commandDescriptors[index];
+            break;
+        }
+    }
+    return descriptor;
+}
+
+enum
+{
+    eKEY_INDEX_FRAME_NUMBER = 0,            // first entry is the frame number
+    eKEY_INDEX_COMMAND = 1,                 // second entry is the command
+    eKEY_INDEX_PARAMETERS = 2,              // first parameter (if there is one), CRC follows the last parameter and after the CRC the request ends
+};
+
+// state of the request that is currently received, it's parsed character by character so at the end of the request it's already completely processed
+static struct
+{
+    uint16_t keyIndex;                              // index of current token
+    uint8_t  length;                                // number of received characters
+    const commandDescriptor_t *descriptor;          // descriptor of received command, NULL as long as command hasn't been received or is unknown
+    uint16_t frameNumber;
+    uint16_t parameters[eMAX_PARAMETERS];
+    uint16_t receivedCrc;
+    uint16_t crc;                                   // CRC calculated over all characters up to the last parameter (including the ';' behind it)
+    uint16_t error;                                 // first detected error
+    uint8_t  byteIndex;                             // binary mode only: byte of current 16 bit value
+    uint8_t  cobsCode;                              // binary mode only: code of current COBS block, 0 before first block
+    uint8_t  cobsRemaining;                         // binary mode only: bytes remaining in current COBS block
+} received = { eKEY_INDEX_FRAME_NUMBER, 0, NULL, 0, { 0 }, 0, eCRC16_X25_INIT, eMESSAGE_ERROR_NONE, 0, 0, 0 };
 
 // set error if not already set
 static void setMessageError(uint16_t newError)
 {
     // only remember the first detected error
-    if (!receiveError)
+    if (!received.error)
     {
-        receiveError = newError;
+        received.error = newError;
     }
 }
 
-// clear set error for next request
-static inline void clearMessageError()
+static inline uint16_t getMessageError()
 {
-    receiveError = eMESSAGE_ERROR_NONE;
+    return received.error;
 }
 
-static inline uint16_t getMessageError()
+// prepare everything for the next request
+static void resetRequest(void)
 {
-    return receiveError;
+    received.keyIndex    = eKEY_INDEX_FRAME_NUMBER;
+    received.length      = 0;
+    received.descriptor  = NULL;
+    received.frameNumber = 0;
+    for (uint8_t index = 0; index < eMAX_PARAMETERS; index++)
+    {
+        received.parameters[index] = 0;
+    }
+    received.receivedCrc = 0;
+    received.crc         = eCRC16_X25_INIT;
+    received.error       = eMESSAGE_ERROR_NONE;
+    received.byteIndex   = 0;
+    received.cobsCode    = 0;
+    received.cobsRemaining = 0;
+    request[0] = '\0';
 }
 
-// handle received request
-static void handleRequest(char *received)
+// index of the token containing the CRC, as long as the command is not known it's behind all tokens received so far
+static inline uint16_t crcKeyIndex(void)
 {
-    static uint16_t nextExpectedFrameNumber = 0;
-    uint16_t crc = eCRC16_X25_INIT;
+    return received.descriptor ? (eKEY_INDEX_PARAMETERS + received.descriptor->parameters) : (received.keyIndex + 1);
+}
 
-    enum
+// process a single character of the current request
+static void parseChar(char character)
+{
+    // keep the first characters for the error response
+    if (received.length < eMAX_REQUEST_ECHO_LENGTH)
     {
-        eCOMMAND_WATCHDOG = 'W',        // value for "watchdog" command
-        eCOMMAND_SET_OUTPUT = 'S',      // value for "set output" command
-        eCOMMAND_READ_INPUT = 'R',      // value for "read input" command
-        eCOMMAND_GET_VERSION = 'V',     // value for "get version" command
-        eCOMMAND_EXECUTE_TEST = 'T',    // value for "execute test" command
-        eCOMMAND_GET_DIAGNOSES = 'D',   // value for "get diagnoses" command
-
-        eCOMMAND_NACK = 'E',            // value for NACK (only sent, never received!)
-    };
+        request[received.length] = character;
+        request[received.length + 1] = '\0';
+    }
 
-    if (received != NULL)
+    if (received.length < eMAX_REQUEST_LENGTH)
     {
-        P2(">>>>%s\n", received);
+        received.length++;
+    }
+    else
+    {
+        setMessageError(eMESSAGE_ERROR_OVERFLOW);
+    }
 
-        enum
+    // stop processing at the first detected error, rest of the request is just ignored until it's complete
+    if (getMessageError())
+    {
+        countUp(&statistics.discardedBytes);
+    }
+    else
+    {
+        // all characters up to the ';' behind the last parameter are CRC protected
+        if (received.keyIndex < crcKeyIndex())
         {
-            eKEY_INDEX_FRAME_NUMBER = 0,            // first entry is the frame number
-            eKEY_INDEX_COMMAND = 1,                 // second entry is the command
-            eKEY_INDEX_EMPTY_COMMAND = 2,           // if command token was empty we will reach this invalid state
-
-            eKEY_INDEX_WATCHDOG = 100,              // steps for "watchdog" command handling...
-            eKEY_INDEX_WATCHDOG_VALUE = 101,        // handle received watchdog value (1 will re-trigger the watchdog, 0 will clear the watchdog immediately)
-            eKEY_INDEX_WATCHDOG_CRC = 102,          // process received CRC
-            eKEY_INDEX_WATCHDOG_END = 103,          // watchdog end state
-
-            eKEY_INDEX_SET_OUTPUT = 200,            // steps for "set output" command handling...
-            eKEY_INDEX_SET_OUTPUT_INDEX = 201,      // index of output to be set
-            eKEY_INDEX_SET_OUTPUT_VALUE = 202,      // value output will be set to
-            eKEY_INDEX_SET_OUTPUT_CRC = 203,        // process received CRC
-            eKEY_INDEX_SET_OUTPUT_END = 204,        // "set output" end state
-
-            eKEY_INDEX_GET_INPUT = 300,             // steps for "read input" command handling...
-            eKEY_INDEX_GET_INPUT_INDEX = 301,       // index of input to be read
-            eKEY_INDEX_GET_INPUT_CRC = 302,         // process received CRC
-            eKEY_INDEX_GET_INPUT_END = 303,         // "read input" end state
-
-            eKEY_INDEX_GET_VERSION = 400,           // steps for "get version" command handling...
-            eKEY_INDEX_GET_VERSION_CRC = 401,       // process received CRC
-            eKEY_INDEX_GET_VERSION_END = 402,       // "get version" end state
-
-            eKEY_INDEX_GET_DIAGNOSES = 500,         // steps for "get diagnoses" command handling...
-            eKEY_INDEX_GET_DIAGNOSES_CRC = 501,     // process received CRC
-            eKEY_INDEX_GET_DIAGNOSES_END = 502,     // "get diagnoses" end state
-
-            eKEY_INDEX_EXECUTE_TEST = 600,          // steps for "execute test" command handling...
-            eKEY_INDEX_EXECUTE_TEST_CRC = 601,      // process received CRC
-            eKEY_INDEX_EXECUTE_TEST_END = 602,      // "execute test" end state
-        };
+            received.crc = crc16X25Step(character, received.crc);
+            P3("{%c}", character);
+        }
 
-        enum
+        if (character == ';')
         {
-            eCRC_CALCULATION_ENABLED,
-            eCRC_CALCULATION_TO_DISABLE,
-            eCRC_CALCULATION_DISABLED,
-        };
-
-        uint16_t keyIndex = 0;
-
-        uint16_t frameNumber = 0;
-        char command = ' ';
-        uint16_t commandIndex = 0;
-        uint16_t commandValue = 0;
-
-        uint16_t calculateCrc = eCRC_CALCULATION_ENABLED;
-        uint16_t receivedCrc = 0;
-
-        clearMessageError();
-
-        for (uint16_t index = 0; received[index] > '\x0A' && !getMessageError(); index++)
+            received.keyIndex++;
+        }
+        else if (received.keyIndex == eKEY_INDEX_FRAME_NUMBER)
         {
-            if (calculateCrc != eCRC_CALCULATION_DISABLED)
+            // handle frame number
+            if (createDecimal(&received.frameNumber, character))
             {
-                crc = crc16X25Step(received[index], crc);
-                P3("{%c}", received[index]);
+                setMessageError(eMESSAGE_ERROR_INVALID_FRAME_NUMBER);
             }
-
-            //Serial.print('[');
-            //Serial.print(keyIndex, DEC);
-            //Serial.print(']');
-
-            if (received[index] == ';')
+        }
+        else if (received.keyIndex == eKEY_INDEX_COMMAND)
+        {
+            // handle command, if command token was not empty (e.g. 1;WW;1;1;) command is invalid
+            if (!received.descriptor)
             {
-                keyIndex++;
-                if (calculateCrc == eCRC_CALCULATION_TO_DISABLE)
-                {
-                    calculateCrc = eCRC_CALCULATION_DISABLED;
-                }
-                continue;
+                received.descriptor = findCommand(character);
             }
-
-            switch (keyIndex)
+            else
             {
-                // handle framen number
-                case eKEY_INDEX_FRAME_NUMBER:
-                    P3("F[");
-                    if (createDecimal(&frameNumber, received[index]))
-                    {
-                        setMessageError(eMESSAGE_ERROR_INVALID_FRAME_NUMBER);
-                    }
-                    P3("%d]", commandValue);
-                    break;
+                received.descriptor = NULL;
+            }
 
-                // handle command and switch to command sub states
-                case eKEY_INDEX_COMMAND:
-                    P3("C[");
-                    // remember received command
-                    command = received[index];
-                    P3("%c]", command);
+            if (!received.descriptor)
+            {
+                setMessageError(eMESSAGE_ERROR_UNKNOWN_COMMAND);
+            }
+            P3("C[%c]", character);
+        }
+        else if (!received.descriptor)
+        {
+            // command token was empty (e.g. 1;;1;1;)
+            setMessageError(eMESSAGE_ERROR_UNKNOWN_COMMAND);
+        }
+        else if (received.keyIndex < crcKeyIndex())
+        {
+            // handle command's parameters
+            uint8_t parameter = received.keyIndex - eKEY_INDEX_PARAMETERS;
+            if (createDecimal(&received.parameters[parameter], character))
+            {
+                setMessageError((received.descriptor->indexParameters & (1 << parameter)) ? eMESSAGE_ERROR_INVALID_INDEX : eMESSAGE_ERROR_INVALID_VALUE);
+            }
+        }
+        else if (received.keyIndex == crcKeyIndex())
+        {
+            // handle command's CRC part
+            if (createDecimal(&received.receivedCrc, character))
+            {
+                setMessageError(eMESSAGE_ERROR_INVALID_CRC);
+            }
+        }
+        else if (received.keyIndex > crcKeyIndex() + 1)
+        {
+            // unknown situation (probably too many fields in the received command), everything behind the CRC's ';' is ignored
+            P3("E(%d)", received.keyIndex);
+            setMessageError(eMESSAGE_ERROR_UNKNOWN_STATE);
+        }
+    }
+}
 
-                    // switch to command's sub states
-                    switch (received[index])
-                    {
-                    case eCOMMAND_WATCHDOG:
-                        keyIndex = eKEY_INDEX_WATCHDOG;
-                        break;
+// process a single (already COBS decoded) byte of the current binary request
+static void parseBinaryChar(char byte)
+{
+    if (received.length < eMAX_REQUEST_LENGTH)
+    {
+        received.length++;
+    }
+    else
+    {
+        setMessageError(eMESSAGE_ERROR_OVERFLOW);
+    }
 
-                    case eCOMMAND_SET_OUTPUT:
-                        keyIndex = eKEY_INDEX_SET_OUTPUT;
-                        break;
+    // stop processing at the first detected error, rest of the request is just ignored until it's complete
+    if (getMessageError())
+    {
+        countUp(&statistics.discardedBytes);
+    }
+    else
+    {
+        // all bytes in front of the CRC are CRC protected
+        if (received.keyIndex < crcKeyIndex())
+        {
+            received.crc = crc16X25Step(byte, received.crc);
+        }
+
+        if (received.keyIndex == eKEY_INDEX_FRAME_NUMBER)
+        {
+            received.frameNumber = (uint8_t)byte;
+            received.keyIndex++;
+        }
+        else if (received.keyIndex == eKEY_INDEX_COMMAND)
+        {
+            received.descriptor = findCommand(byte);
+            if (!received.descriptor)
+            {
+                setMessageError(eMESSAGE_ERROR_UNKNOWN_COMMAND);
+            }
+            received.keyIndex++;
+        }
+        else if (received.keyIndex <= crcKeyIndex())
+        {
+            // parameters and CRC are little endian values
+            uint8_t parameter = received.keyIndex - eKEY_INDEX_PARAMETERS;
+            bool crcValue = (received.keyIndex == crcKeyIndex());
+            uint16_t *value = crcValue ? &received.receivedCrc : &received.parameters[parameter];
+            *value |= (uint16_t)(uint8_t)byte << (8 * received.byteIndex);
+
+            if (!received.byteIndex && (crcValue || (received.descriptor->wideParameters & (1 << parameter))))
+            {
+                received.byteIndex = 1;
+            }
+            else
+            {
+                received.byteIndex = 0;
+                received.keyIndex++;
+            }
+        }
+        else
+        {
+            // request is too long
+            setMessageError(eMESSAGE_ERROR_UNKNOWN_STATE);
+        }
+    }
+}
+
+// handle completely received request
+static void handleRequest(void)
+{
+    P2(">>>>%s\n", request);
+    countUp(&statistics.receivedFrames);
 
-                    case eCOMMAND_READ_INPUT:
-                        keyIndex = eKEY_INDEX_GET_INPUT;
-                        break;
+    if (getMessageError() == eMESSAGE_ERROR_OVERFLOW)
+    {
+        P2(">>>>overflow\n");
+        countUp(&statistics.nacks[eMESSAGE_ERROR_OVERFLOW]);
+        startResponse();
+        addFrameNumber(nextExpectedFrameNumber);
+        addChar(eCOMMAND_NACK);
+        addByte(eMESSAGE_ERROR_OVERFLOW);
+        finishResponse();
+    }
+    else
+    {
+        bool inFlight = false;                              // request belongs to the requests sent behind the expected one
+        char command = received.descriptor ? received.descriptor->command : ' ';
+        uint16_t commandIndex = received.parameters[0];     // for commands with index and value the index is the first parameter...
+        uint16_t commandValue = received.parameters[(received.descriptor && (received.descriptor->parameters > 1)) ? 1 : 0];  // ...and the value the second one
 
-                    case eCOMMAND_GET_VERSION:
-                        keyIndex = eKEY_INDEX_GET_VERSION;
-                        calculateCrc = eCRC_CALCULATION_TO_DISABLE;         // "get version" has no parameters so we have to stop CRC calculation right here
-                        P3("X");
-                        break;
+        if (!received.descriptor)
+        {
+            // empty request or command token has been missing, it can't have a valid CRC (an empty or unknown command token has set
+            // eMESSAGE_ERROR_UNKNOWN_COMMAND already)
+            setMessageError(eMESSAGE_ERROR_INVALID_CRC);
+        }
+        else if ((transferMode == eTRANSFER_MODE_BINARY) && (received.keyIndex <= crcKeyIndex()))
+        {
+            // binary request is too short
+            setMessageError(eMESSAGE_ERROR_INVALID_CRC);
+        }
 
-                    case eCOMMAND_GET_DIAGNOSES:
-                        keyIndex = eKEY_INDEX_GET_DIAGNOSES;
-                        calculateCrc = eCRC_CALCULATION_TO_DISABLE;         // "get diagnoses" has no parameters so we have to stop CRC calculation right here
-                        P3("X");
-                        break;
+        // crc check
+        uint16_t crc = crc16X25Xor(received.crc);
+        P3("\nCRCs: [%u] =?= [%u]\n", crc, received.receivedCrc);
+        if ((crc != received.receivedCrc) && !IGNORE_CRC)
+        {
+            setMessageError(eMESSAGE_ERROR_INVALID_CRC);
+        }
+        else
+        {
+            // frame number validation
+            uint16_t expectedFrameNumber = (transferMode == eTRANSFER_MODE_BINARY) ? (uint8_t)nextExpectedFrameNumber : nextExpectedFrameNumber;
+            if ((received.frameNumber != expectedFrameNumber) && !IGNORE_FRAME_NUMBER)
+            {
+                P3("[%d]!=[%d+1]", received.frameNumber, nextExpectedFrameNumber);
+                setMessageError(eMESSAGE_ERROR_UNEXPECTED_FRAME_NUMBER);
 
-                    case eCOMMAND_EXECUTE_TEST:
-                        keyIndex = eKEY_INDEX_EXECUTE_TEST;
-                        calculateCrc = eCRC_CALCULATION_TO_DISABLE;         // "execute test" has no parameters so we have to stop CRC calculation right here
-                        P3("X");
-                        break;
+                uint16_t offset = received.frameNumber - expectedFrameNumber;
+                if (transferMode == eTRANSFER_MODE_BINARY)
+                {
+                    offset = (uint8_t)offset;                   // binary frame numbers wrap at 256
+                }
+                inFlight = (offset < windowSize);
+            }
 
-                    default:
-                        setMessageError(eMESSAGE_ERROR_UNKNOWN_COMMAND);
-                        break;
+            // validate command parameter(s)
+            switch (command)
+            {
+                case eCOMMAND_WATCHDOG:
+                case eCOMMAND_HEARTBEAT:
+                    // watchdog command has only a value but no index
+                    if (commandValue > 1)   // only 0 and 1 are allowed values for the watchdog state!
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                    }
+                    if (!versionReadCommandReceived)   // only 0 and 1 are allowed values for the watchdog state!
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_STARTUP);
                     }
                     break;
 
-                // if command token was empty (e.g. 1;;1;1;) or initial command stage (e.g. 1;WW;1;1;) is reached than command is invalid
-                case eKEY_INDEX_EMPTY_COMMAND:
-                case eKEY_INDEX_WATCHDOG:
-                case eKEY_INDEX_SET_OUTPUT:
-                case eKEY_INDEX_GET_INPUT:
-                case eKEY_INDEX_GET_VERSION:
-                case eKEY_INDEX_GET_DIAGNOSES:
-                case eKEY_INDEX_EXECUTE_TEST:
-                    setMessageError(eMESSAGE_ERROR_UNKNOWN_COMMAND);
+                case eCOMMAND_SET_OUTPUT:
+                    // set output command has an index and a value
+                    if (commandIndex >= eSUPPORTED_OUTPUTS)     // this avoids that watchdog is changed with "set output" command, since eSUPPORTED_OUTPUTS is at least one smaller than number of existing outputs!
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_INDEX);
+                    }
+                    else if (commandValue > 1)  // only 0 and 1 are allowed values for the output state!
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                    }
                     break;
 
-                // handle command's value part
-                case eKEY_INDEX_WATCHDOG_VALUE:
-                case eKEY_INDEX_SET_OUTPUT_VALUE:
-                    P3("V[");
-                    if (createDecimal(&commandValue, received[index]))
+                case eCOMMAND_READ_INPUT:
+                    // get input command has only an index but no value
+                    if (commandIndex >= eSUPPORTED_INPUTS)
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_INDEX);
+                    }
+                    break;
+
+                case eCOMMAND_SET_BAUD_RATE:
+                    // set baud rate command has only a value that has to be one of the supported baud rates
+                    if (!baudRateSupported(commandValue))
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                    }
+                    break;
+
+                case eCOMMAND_SET_OUTPUTS:
+                    // set outputs command has output states and a change mask, both are bit masks
+                    if ((received.parameters[0] > eALL_OUTPUTS_MASK) || (received.parameters[1] > eALL_OUTPUTS_MASK))
                     {
                         setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
                     }
-                    P3("%d]", commandValue);
-                    calculateCrc = eCRC_CALCULATION_TO_DISABLE;     // last CRC protected element in message so stop CRC calculation now!
-                    P3("X");
                     break;
 
-                // handle command's index part
-                case eKEY_INDEX_SET_OUTPUT_INDEX:
-                    P3("I[");
-                    if (createDecimal(&commandIndex, received[index]))
+                case eCOMMAND_SET_TRANSFER_MODE:
+                    // set transfer mode command has only a value that has to be a known mode
+                    if (commandValue > eTRANSFER_MODE_BINARY)
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                    }
+                    break;
+
+                case eCOMMAND_SET_WINDOW_SIZE:
+                    // set window size command has only a value that has to be between 1 and eMAX_WINDOW_SIZE
+                    if ((commandValue < 1) || (commandValue > eMAX_WINDOW_SIZE))
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                    }
+                    break;
+
+                case eCOMMAND_SET_INPUT_FILTER:
+                    // set input filter command has an index (the watchdog readback can't be filtered), a mode and the rise and fall samples
+                    if ((commandIndex >= eSUPPORTED_INPUTS) || (commandIndex == eWATCHDOG_TEST_READBACK))
                     {
                         setMessageError(eMESSAGE_ERROR_INVALID_INDEX);
                     }
-                    P3("%d]", commandIndex);
+                    else if (received.parameters[1] >= eINPUT_FILTERS)
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                    }
+                    else if (received.parameters[1] != eINPUT_FILTER_NONE)
+                    {
+                        // rise and fall have to be at least one sample, for the majority vote they can't exceed the window and together they
+                        // have to be larger than the window otherwise the input would toggle with each sample
+                        bool majority = (received.parameters[1] == eINPUT_FILTER_MAJORITY);
+                        uint8_t maxSamples = majority ? eINPUT_FILTER_MAJORITY_WINDOW : 0xFF;
+                        if (!received.parameters[2] || !received.parameters[3] || (received.parameters[2] > maxSamples) || (received.parameters[3] > maxSamples) ||
+                            (majority && ((received.parameters[2] + received.parameters[3]) <= eINPUT_FILTER_MAJORITY_WINDOW)))
+                        {
+                            setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                        }
+                    }
                     break;
 
-                // handle command's index part
-                case eKEY_INDEX_GET_INPUT_INDEX:
-                    P3("I[");
-                    if (createDecimal(&commandIndex, received[index]))
+                case eCOMMAND_ENABLE_EVENTS:
+                case eCOMMAND_ENABLE_EDGE_CAPTURE:
+                    // enable events and enable edge capture commands have only a value that can be 0 or 1
+                    if (commandValue > 1)
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                    }
+                    break;
+
+                case eCOMMAND_SET_COUNTER:
+                    // set counter command has an index (the watchdog readback can't be counted) and a gate time
+                    if (!ioHandler_counterSupported(commandIndex))
                     {
                         setMessageError(eMESSAGE_ERROR_INVALID_INDEX);
                     }
-                    P3("%d]", commandIndex);
-                    calculateCrc = eCRC_CALCULATION_TO_DISABLE;     // last CRC protected element in message so stop CRC calculation now!
-                    P3("X");
+                    else if (commandValue > eMAX_GATE_TIME)
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                    }
                     break;
 
-                // handle command's CRC part
-                case eKEY_INDEX_WATCHDOG_CRC:
-                case eKEY_INDEX_SET_OUTPUT_CRC:
-                case eKEY_INDEX_GET_INPUT_CRC:
-                case eKEY_INDEX_GET_VERSION_CRC:
-                case eKEY_INDEX_GET_DIAGNOSES_CRC:
-                case eKEY_INDEX_EXECUTE_TEST_CRC:
-                    P3("S[");
-                    if (createDecimal(&receivedCrc, received[index]))
+                case eCOMMAND_SET_OUTPUT_PROFILE:
+                    // set output profile command has an index (only not pulsed outputs can be held), the pull-in time and the hold duty
+                    if (!ioHandler_holdSupported(commandIndex))
                     {
-                        setMessageError(eMESSAGE_ERROR_INVALID_CRC);
+                        setMessageError(eMESSAGE_ERROR_INVALID_INDEX);
+                    }
+                    else if ((received.parameters[1] > eMAX_PULL_IN_TIME) || (received.parameters[2] > eMAX_HOLD_DUTY) ||
+                             (received.parameters[2] && !received.parameters[1]))
+                    {
+                        // a held output needs a pull-in time, otherwise the relay might never pull in
+                        setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                    }
+                    else if (!ioHandler_holdDutyAvailable(commandIndex, received.parameters[2]))
+                    {
+                        // the hold duty is shared, another duty can only be set as long as no other output is held
+                        setMessageError(eMESSAGE_ERROR_BUSY);
                     }
-                    P3("%u]", receivedCrc);
                     break;
 
-                case eKEY_INDEX_WATCHDOG_END:
-                case eKEY_INDEX_SET_OUTPUT_END:
-                case eKEY_INDEX_GET_INPUT_END:
-                case eKEY_INDEX_GET_VERSION_END:
-                case eKEY_INDEX_GET_DIAGNOSES_END:
-                case eKEY_INDEX_EXECUTE_TEST_END:
-                    // nth. to do here
+                case eCOMMAND_SET_TIMED_OUTPUT:
+                    // set timed output command has an index, a value and a duration (any duration is valid)
+                    if (commandIndex >= eSUPPORTED_OUTPUTS)
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_INDEX);
+                    }
+                    else if (received.parameters[1] > 1)
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                    }
                     break;
 
-                // unknown situation (probably too many fields in the received command)
-                default:
-                    P3("E(%d)", keyIndex);
-                    setMessageError(eMESSAGE_ERROR_UNKNOWN_STATE);
+                case eCOMMAND_GET_TIMED_OUTPUT:
+                    // get timed output command has only an index
+                    if (commandIndex >= eSUPPORTED_OUTPUTS)
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_INDEX);
+                    }
                     break;
-            }
-        }
 
-        // crc check
-        crc = crc16X25Xor(crc);
-        P3("\nCRCs: [%u] =?= [%u]\n", crc, receivedCrc);
-        if ((crc != receivedCrc) && !IGNORE_CRC)
-        {
-            setMessageError(eMESSAGE_ERROR_INVALID_CRC);
-        }
-        else
-        {
-            // frame number validation
-            if ((frameNumber != uint16_t(nextExpectedFrameNumber)) && !IGNORE_FRAME_NUMBER)
-            {
-                P3("[%d]!=[%d+1]", frameNumber, nextExpectedFrameNumber);
-                setMessageError(eMESSAGE_ERROR_UNEXPECTED_FRAME_NUMBER);
-            }
+                case eCOMMAND_SET_SEQUENCE_STEP:
+                {
+                    // set sequence step command has an index, the outputs to be changed, their states and a duration of at least one tick
+                    uint8_t step;
+                    uint16_t remaining;
+                    if (commandIndex >= eSEQUENCE_STEPS)
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_INDEX);
+                    }
+                    else if ((received.parameters[1] > eALL_OUTPUTS_MASK) || (received.parameters[2] > eALL_OUTPUTS_MASK) ||
+                             !received.parameters[3])
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                    }
+                    else if (ioHandler_getSequenceState(&step, &remaining) == eSEQUENCE_RUNNING)
+                    {
+                        setMessageError(eMESSAGE_ERROR_BUSY);
+                    }
+                    break;
+                }
 
-            // validate command parameter(s)
-            switch (command)
-            {
-                case eCOMMAND_WATCHDOG:
-                    // watchdog command has only a value but no index
-                    if (commandValue > 1)   // only 0 and 1 are allowed values for the watchdog state!
+                case eCOMMAND_GET_SEQUENCE_STEP:
+                    // get sequence step command has only an index
+                    if (commandIndex >= eSEQUENCE_STEPS)
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_INDEX);
+                    }
+                    break;
+
+                case eCOMMAND_RUN_SEQUENCE:
+                    // run sequence command has an action (0 = stop, 1 = start, 2 = status) and the number of steps (only used by start),
+                    // steps aren't delayed by the pull-in schedule, so a sequence with a step switching ON too many outputs isn't started
+                    if ((received.parameters[0] > 2) || (received.parameters[1] > eSEQUENCE_STEPS) ||
+                        ((received.parameters[0] == 1) && !received.parameters[1]))
                     {
                         setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
                     }
-                    if (!versionReadCommandReceived)   // only 0 and 1 are allowed values for the watchdog state!
+                    else if ((received.parameters[0] == 1) && !ioHandler_sequenceFitsSchedule(received.parameters[1]))
                     {
-                        setMessageError(eMESSAGE_ERROR_INVALID_STARTUP);
+                        setMessageError(eMESSAGE_ERROR_BUSY);
                     }
                     break;
 
-                case eCOMMAND_SET_OUTPUT:
-                    // set output command has an index and a value
-                    if (commandIndex >= eSUPPORTED_OUTPUTS)     // this avoids that watchdog is changed with "set output" command, since eSUPPORTED_OUTPUTS is at least one smaller than number of existing outputs!
+                case eCOMMAND_SET_OUTPUT_CONFIG:
+                    // set output configuration command has an index, the pulsed flag and the pulse period, it's only accepted while
+                    // the watchdog is not running
+                    if (commandIndex >= eSUPPORTED_OUTPUTS)
                     {
                         setMessageError(eMESSAGE_ERROR_INVALID_INDEX);
                     }
-                    else if (commandValue > 1)  // only 0 and 1 are allowed values for the output state!
+                    else if ((received.parameters[1] > 1) || !received.parameters[2] || (received.parameters[2] > eMAX_PULSE_PERIOD))
                     {
                         setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
                     }
+                    else if (watchdog_running() || config_writing())
+                    {
+                        setMessageError(eMESSAGE_ERROR_BUSY);
+                    }
                     break;
 
-                case eCOMMAND_READ_INPUT:
-                    // get input command has only an index but no value
-                    if (commandIndex >= eSUPPORTED_INPUTS)
+                case eCOMMAND_GET_PARAMETER:
+                    // get parameter command has only an index
+                    if (commandIndex >= eCONFIG_PARAMETERS)
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_INDEX);
+                    }
+                    break;
+
+                case eCOMMAND_STAGE_PARAMETER:
+                    // stage parameter command has an index and a value within the parameter limits, a baud rate has to be a supported one
+                    if (commandIndex >= eCONFIG_PARAMETERS)
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_INDEX);
+                    }
+                    else if (((commandIndex == eCONFIG_BAUD_RATE) && !baudRateSupported(received.parameters[1])) ||
+                             !config_parameterValid(commandIndex, received.parameters[1]))
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                    }
+                    break;
+
+                case eCOMMAND_WRITE_CONFIG:
+                    // write configuration command has an action (0 = discard, 1 = commit, 2 = status), commit isn't possible while the
+                    // watchdog is running or the previous commit is still being written
+                    if (commandValue > 2)
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                    }
+                    else if ((commandValue == 1) && (watchdog_running() || config_writing()))
+                    {
+                        setMessageError(eMESSAGE_ERROR_BUSY);
+                    }
+                    break;
+
+                case eCOMMAND_GET_STATISTICS:
+                    // get statistics command has a page and the reset flag
+                    if ((received.parameters[0] >= eSTATISTICS_PAGES) || (received.parameters[1] > 1))
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                    }
+                    break;
+
+                case eCOMMAND_GET_LATENCIES:
+                    // get latencies command has all requests (0) or the character of a known command and a reset flag
+                    if (((received.parameters[0] != eLATENCY_ALL_REQUESTS) && ((received.parameters[0] > 0xFF) || !findCommand(received.parameters[0]))) ||
+                        (received.parameters[1] > 1))
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                    }
+                    break;
+
+                case eCOMMAND_GET_OUTPUT_CONFIG:
+                    // get output configuration command has only an index
+                    if (commandIndex >= eSUPPORTED_OUTPUTS)
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_INDEX);
+                    }
+                    break;
+
+                case eCOMMAND_SET_PULL_IN_SCHEDULE:
+                {
+                    // set pull-in schedule command has the number of outputs switched ON within a gap (0 = no limit) and the gap,
+                    // it's not changed while the sequence is running because the running steps have been checked against the old one
+                    uint8_t step;
+                    uint16_t remaining;
+                    if ((received.parameters[0] > eSUPPORTED_OUTPUTS) || (received.parameters[1] > eMAX_PULL_IN_GAP) ||
+                        (received.parameters[0] && !received.parameters[1]))
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                    }
+                    else if (ioHandler_getSequenceState(&step, &remaining) == eSEQUENCE_RUNNING)
+                    {
+                        setMessageError(eMESSAGE_ERROR_BUSY);
+                    }
+                    break;
+                }
+
+                case eCOMMAND_GET_COUNTER:
+                    // get counter command has only an index
+                    if (!ioHandler_counterSupported(commandIndex))
                     {
                         setMessageError(eMESSAGE_ERROR_INVALID_INDEX);
                     }
                     break;
+
+                case eCOMMAND_GET_EDGES:
+                    // get edges command has only the number of edges to be removed that can't exceed the capture ring
+                    if (commandValue > eINPUT_EDGES)
+                    {
+                        setMessageError(eMESSAGE_ERROR_INVALID_VALUE);
+                    }
+                    break;
             }
         }
 
+        // a retransmission of an already executed request (e.g. because its response got lost) gets the same response again without
+        // executing the command a second time
+        const cachedResponse_t *cachedResponse = NULL;
+        if (getMessageError() == eMESSAGE_ERROR_UNEXPECTED_FRAME_NUMBER)
+        {
+            cachedResponse = findCachedResponse(received.frameNumber, received.receivedCrc);
+        }
+        if (cachedResponse)
+        {
+            P3("replayed [%d]", received.frameNumber);
+            countUp(&statistics.replayedResponses);
+            replayResponse(cachedResponse);
+            transferMode = requestedTransferMode;
+            return;
+        }
+
+        // after a NACK the host resends everything starting with the expected frame number, so requests it had already sent behind
+        // the missing one are dropped without a response instead of flooding the host with a NACK for each of them
+        if (resynchronizing && inFlight && (getMessageError() == eMESSAGE_ERROR_UNEXPECTED_FRAME_NUMBER))
+        {
+            P3("dropped [%d]", received.frameNumber);
+            countUp(&statistics.droppedRequests);
+            transferMode = requestedTransferMode;
+            return;
+        }
+
         // prepare response and execute command
-        uint16_t index = 0;
-        index = addInteger(response, index, nextExpectedFrameNumber);
+        startResponse();
+        addFrameNumber(nextExpectedFrameNumber);
         if (getMessageError())
         {
-            index = addChar(response, index, eCOMMAND_NACK);
-            index = addInteger(response, index, getMessageError());
-            index = addRequest(response, index, received);
-            index = addInteger(response, index, crc);
+            countUp(&statistics.nacks[getMessageError()]);
+            addChar(eCOMMAND_NACK);
+            addByte(getMessageError());
+            addRequest(request);
+            addWord(crc);
+            resynchronizing = (windowSize > 1);
         }
         else
         {
-            index = addChar(response, index, command);
+            countUp(&commandCounts[received.descriptor - commandDescriptors]);
+            cacheResponse(received.frameNumber, received.receivedCrc);
+            addChar(command);
             switch (command)
             {
                 case eCOMMAND_WATCHDOG:
-                    index = addInteger(response, index, watchdog_readWatchdog());
+                    addByte(watchdog_readWatchdog());
+                    watchdog_setWatchdog(commandValue);
+                    addByte(watchdog_readWatchdog());
+                    addByte(watchdog_resetPortMustBeLocked() ? 1: 0);
+                    break;
+
+                case eCOMMAND_HEARTBEAT:
+                    addByte(watchdog_readWatchdog());
                     watchdog_setWatchdog(commandValue);
-                    index = addInteger(response, index, watchdog_readWatchdog());
-                    index = addInteger(response, index, watchdog_resetPortMustBeLocked() ? 1: 0);
+                    addByte(watchdog_readWatchdog());
+                    addByte(watchdog_resetPortMustBeLocked() ? 1: 0);
+                    addByte(ioHandler_getInputs());
+                    addByte(ioHandler_getOutputs());
+                    addWord(watchdog_getCounter());
+                    addByte(watchdog_getTestState());
+                    addLong(watchdog_getTestRemainingTime());
+                    addByte(errorAndDiagnosis_pending() ? 1 : 0);
                     break;
 
                 case eCOMMAND_SET_OUTPUT:
-                    index = addInteger(response, index, commandIndex);
-                    index = addInteger(response, index, ioHandler_getOutput(commandIndex));
+                    addByte(commandIndex);
+                    addByte(ioHandler_getOutput(commandIndex));
                     ioHandler_setOutput(commandIndex, commandValue);
-                    index = addInteger(response, index, ioHandler_getOutput(commandIndex));
+                    addByte(ioHandler_getOutput(commandIndex));
                     break;
 
                 case eCOMMAND_READ_INPUT:
-                    index = addInteger(response, index, commandIndex);
-                    index = addInteger(response, index, ioHandler_getInput(commandIndex));
+                    addByte(commandIndex);
+                    addByte(ioHandler_getInput(commandIndex));
                     break;
 
                 case eCOMMAND_GET_VERSION:
-                    index = addString(response, index, VERSION_FIELD.version);
-                    index = finalizeToken(response, index);
+                    addString(VERSION_FIELD.version);
+                    finalizeToken();
                     versionReadCommandReceived = true;         // remember that version has been requested, therefore, watchdog can be switched ON now
                     break;
 
                 case eCOMMAND_GET_DIAGNOSES:
-                    index = addInteger(response, index, errorAndDiagnosis_getDiagnoses());
-                    index = addInteger(response, index, errorAndDiagnosis_getErrorNumber());
-                    index = addInteger(response, index, errorAndDiagnosis_getExecutedTests());
+                    addWord(errorAndDiagnosis_getDiagnoses());
+                    addWord(errorAndDiagnosis_getErrorNumber());
+                    addWord(errorAndDiagnosis_getExecutedTests());
                     break;
 
                 case eCOMMAND_EXECUTE_TEST:
-                    index = addInteger(response, index, watchdog_requestSelfTest());
+                    addByte(watchdog_requestSelfTest());
+                    break;
+
+                case eCOMMAND_SET_BAUD_RATE:
+                    addWord(commandValue);
+                    requestedBaudRate = commandValue;
+                    baudRateState = eBAUD_RATE_SWITCH_PENDING;      // switch as soon as this response has been sent with the current baud rate
+                    break;
+
+                case eCOMMAND_SET_OUTPUTS:
+                    // an empty mask changes nothing, so a host that computed no changes can't switch all outputs by accident
+                    addByte(ioHandler_getOutputs());
+                    ioHandler_setOutputs(received.parameters[1], received.parameters[0]);
+                    addByte(ioHandler_getOutputs());
+                    addWord(ioHandler_getPullInDelay());
+                    break;
+
+                case eCOMMAND_READ_ALL:
+                    addByte(ioHandler_getInputs());
+                    addByte(ioHandler_getOutputs());
+                    break;
+
+                case eCOMMAND_SET_TRANSFER_MODE:
+                    addByte(commandValue);
+                    requestedTransferMode = commandValue;           // switch as soon as this response has been sent in the current mode
+                    break;
+
+                case eCOMMAND_SET_WINDOW_SIZE:
+                    addByte(commandValue);
+                    windowSize = commandValue;
+                    break;
+
+                case eCOMMAND_ENABLE_EVENTS:
+                    addByte(commandValue);
+                    if (commandValue && !eventsEnabled)
+                    {
+                        nextEventToSend = ioHandler_getNextEventSequence();     // only changes from now on are sent
+                    }
+                    eventsEnabled = commandValue;
+                    addWord(ioHandler_getNextEventSequence());
+                    break;
+
+                case eCOMMAND_GET_EVENT:
+                {
+                    inputEvent_t event = { commandValue, 0, 0 };
+                    bool available = ioHandler_getEvent(commandValue, &event);
+                    addByte(available ? (uint16_t)(ioHandler_getNextEventSequence() - event.sequence) : 0);
+                    addWord(event.sequence);
+                    addByte(event.inputs);
+                    addLong(event.ticks);
+                    break;
+                }
+
+                case eCOMMAND_SET_INPUT_FILTER:
+                    ioHandler_setInputFilter(commandIndex, received.parameters[1], received.parameters[2], received.parameters[3]);
+                    addByte(commandIndex);
+                    addByte(received.parameters[1]);
+                    addByte(received.parameters[2]);
+                    addByte(received.parameters[3]);
+                    break;
+
+                case eCOMMAND_ENABLE_EDGE_CAPTURE:
+                    addByte(commandValue);
+                    ioHandler_enableEdgeCapture(commandValue);
+                    break;
+
+                case eCOMMAND_GET_EDGES:
+                {
+                    // edges are removed when the host acknowledges them with the next request, so a lost response doesn't lose edges
+                    ioHandler_removeEdges(commandValue);
+                    uint8_t count = ioHandler_getEdgeCount();
+                    addWord(ioHandler_getLostEdges());
+                    addByte(count);
+                    if (count > eEDGES_PER_RESPONSE)
+                    {
+                        count = eEDGES_PER_RESPONSE;
+                    }
+                    addByte(count);
+                    for (uint8_t index = 0; index < count; index++)
+                    {
+                        inputEdge_t edge = { 0, 0, 0 };
+                        ioHandler_getEdge(index, &edge);
+                        addLong(edge.ticks);
+                        addWord(edge.counts * eTIMER_COUNT_TIME);
+                        addByte(edge.inputs);
+                    }
+                    break;
+                }
+
+                case eCOMMAND_GET_STATISTICS:
+                {
+                    // counters of the responded page are cleared if requested, so no increment gets lost between reading and clearing
+                    uint8_t page = received.parameters[0];
+                    bool reset = received.parameters[1];
+                    addByte(page);
+                    addByte(eSTATISTICS_PAGES);
+                    if (page == eSTATISTICS_PAGE_LINK)
+                    {
+                        uartStatistics_t uartStatistics;
+                        uart_getStatistics(&uartStatistics, reset);
+                        addLong(statistics.receivedFrames);
+                        addLong(statistics.sentFrames);
+                        addWord(statistics.replayedResponses);
+                        addWord(statistics.droppedRequests);
+                        addWord(statistics.discardedBytes);
+                        addWord(uartStatistics.overruns);
+                        addWord(uartStatistics.framingErrors);
+                        addWord(uartStatistics.rxOverflows);
+                        if (reset)
+                        {
+                            statistics.receivedFrames = statistics.sentFrames = 0;
+                            statistics.replayedResponses = statistics.droppedRequests = statistics.discardedBytes = 0;
+                        }
+                    }
+                    else if (page == eSTATISTICS_PAGE_NACKS)
+                    {
+                        for (uint8_t error = eMESSAGE_ERROR_NONE + 1; error < eMESSAGE_ERRORS; error++)
+                        {
+                            addWord(statistics.nacks[error]);
+                            if (reset)
+                            {
+                                statistics.nacks[error] = 0;
+                            }
+                        }
+                    }
+                    else if (page == eSTATISTICS_PAGE_TIMING)
+                    {
+                        timerStatistics_t timing;
+                        timer_getStatistics(&timing, reset);
+                        addLong(timing.samples);
+                        addWord(timing.minExecution);
+                        addWord(timing.meanExecution);
+                        addWord(timing.maxExecution);
+                        addWord(timing.minLatency);
+                        addWord(timing.meanLatency);
+                        addWord(timing.maxLatency);
+                        addWord(timing.overruns);
+                        addWord(timing.isrLoad);
+                        addLong(timing.idleLoops);
+                        addLong(timing.maxIdleLoops);
+                    }
+                    else if (page == eSTATISTICS_PAGE_MEMORY)
+                    {
+                        addWord(stackMonitor_getMinFree());
+                        addWord(stackMonitor_getFree());
+                        addWord(eSTACK_LOW_THRESHOLD);
+                    }
+                    else
+                    {
+                        uint8_t first = (page - eSTATISTICS_PAGE_COMMANDS) * eCOMMANDS_PER_STATISTICS_PAGE;
+                        uint8_t count = ((eCOMMANDS - first) < eCOMMANDS_PER_STATISTICS_PAGE) ? (eCOMMANDS - first) : eCOMMANDS_PER_STATISTICS_PAGE;
+                        addByte(count);
+                        for (uint8_t index = first; index < first + count; index++)
+                        {
+                            addChar(commandDescriptors[index].command);
+                            addWord(commandCounts[index]);
+                            if (reset)
+                            {
+                                commandCounts[index] = 0;
+                            }
+                        }
+                    }
+                    break;
+                }
+
+                case eCOMMAND_GET_LATENCIES:
+                {
+                    // selecting another command restarts the command histograms, the ones of all requests are kept
+                    char selection = received.parameters[0];
+                    latencyHistograms_t *histograms = &allLatencies;
+                    if (selection != eLATENCY_ALL_REQUESTS)
+                    {
+                        if (selection != latencyCommand)
+                        {
+                            selectLatencyCommand(selection);
+                        }
+                        histograms = &commandLatencies;
+                    }
+                    addByte(selection);
+                    for (uint8_t bucket = 0; bucket < eLATENCY_BUCKETS; bucket++)
+                    {
+                        addWord(histograms->queueing[bucket]);
+                    }
+                    for (uint8_t bucket = 0; bucket < eLATENCY_BUCKETS; bucket++)
+                    {
+                        addWord(histograms->service[bucket]);
+                    }
+                    if (received.parameters[1])
+                    {
+                        clearLatencies(histograms);
+                    }
+                    break;
+                }
+
+                case eCOMMAND_GET_HISTORY:
+                {
+                    // entries older than the ones kept are skipped as well as damaged ones, continueSequence tells the host where to go on
+                    uint16_t nextSequence = history_getNextSequence();
+                    uint16_t sequence = commandValue;
+                    if ((int16_t)(sequence - nextSequence) >= 0)
+                    {
+                        sequence = nextSequence;                        // requested entry hasn't been logged so far
+                    }
+                    else if ((uint16_t)(nextSequence - sequence) > eHISTORY_ENTRIES)
+                    {
+                        sequence = nextSequence - eHISTORY_ENTRIES;     // requested entry has been overwritten already
+                    }
+
+                    historyEntry_t entries[eHISTORY_PER_RESPONSE];
+                    uint8_t count = 0;
+                    for (; (sequence != nextSequence) && (count < eHISTORY_PER_RESPONSE); sequence++)
+                    {
+                        if (history_getEntry(sequence, &entries[count]))
+                        {
+                            count++;
+                        }
+                    }
+
+                    addWord(nextSequence);
+                    addWord(history_getLostEntries());
+                    addWord(sequence);
+                    addByte(count);
+                    for (uint8_t index = 0; index < count; index++)
+                    {
+                        addWord(entries[index].sequence);
+                        addWord(entries[index].boot);
+                        addLong(entries[index].ticks);
+                        addByte(entries[index].type);
+                        addWord(entries[index].code);
+                    }
+                    break;
+                }
+
+                case eCOMMAND_SET_COUNTER:
+                    ioHandler_setCounter(commandIndex, commandValue);
+                    addByte(commandIndex);
+                    addWord(commandValue);
+                    break;
+
+                case eCOMMAND_SET_OUTPUT_PROFILE:
+                    ioHandler_setOutputProfile(commandIndex, received.parameters[1], received.parameters[2]);
+                    addByte(commandIndex);
+                    addWord(received.parameters[1]);
+                    addByte(received.parameters[2]);
+                    break;
+
+                case eCOMMAND_SET_TIMED_OUTPUT:
+                    addByte(commandIndex);
+                    addByte(ioHandler_getOutput(commandIndex));
+                    ioHandler_setTimedOutput(commandIndex, received.parameters[1], received.parameters[2]);
+                    addByte(ioHandler_getOutput(commandIndex));
+                    addWord(received.parameters[2]);
+                    break;
+
+                case eCOMMAND_GET_TIMED_OUTPUT:
+                {
+                    bool revertValue;
+                    uint16_t remaining = ioHandler_getTimedOutput(commandIndex, &revertValue);
+                    addByte(commandIndex);
+                    addByte(ioHandler_getOutput(commandIndex));
+                    addWord(remaining);
+                    addByte(revertValue);
+                    break;
+                }
+
+                case eCOMMAND_SET_SEQUENCE_STEP:
+                case eCOMMAND_GET_SEQUENCE_STEP:
+                {
+                    sequenceStep_t step;
+                    if (command == eCOMMAND_SET_SEQUENCE_STEP)
+                    {
+                        step.mask     = received.parameters[1];
+                        step.values   = received.parameters[2] & received.parameters[1];
+                        step.duration = received.parameters[3];
+                        ioHandler_setSequenceStep(commandIndex, &step);
+                    }
+                    ioHandler_getSequenceStep(commandIndex, &step);
+                    addByte(commandIndex);
+                    addByte(step.mask);
+                    addByte(step.values);
+                    addWord(step.duration);
+                    break;
+                }
+
+                case eCOMMAND_RUN_SEQUENCE:
+                {
+                    uint8_t step;
+                    uint16_t remaining;
+                    if (received.parameters[0] == 0)
+                    {
+                        ioHandler_stopSequence();
+                    }
+                    else if (received.parameters[0] == 1)
+                    {
+                        ioHandler_startSequence(received.parameters[1]);
+                    }
+                    addByte(ioHandler_getSequenceState(&step, &remaining));
+                    addByte(step);
+                    addWord(remaining);
+                    break;
+                }
+
+                case eCOMMAND_SET_OUTPUT_CONFIG:
+                case eCOMMAND_GET_OUTPUT_CONFIG:
+                {
+                    bool stored = config_stored();
+                    if (command == eCOMMAND_SET_OUTPUT_CONFIG)
+                    {
+                        stored = ioHandler_setOutputConfig(commandIndex, received.parameters[1], received.parameters[2]);
+                    }
+                    uint8_t pulsePeriod;
+                    bool pulsed = ioHandler_getOutputConfig(commandIndex, &pulsePeriod);
+                    addByte(commandIndex);
+                    addByte(pulsed);
+                    addByte(pulsePeriod);
+                    addByte(stored);
+                    break;
+                }
+
+                case eCOMMAND_GET_PARAMETER:
+                case eCOMMAND_STAGE_PARAMETER:
+                    if (command == eCOMMAND_STAGE_PARAMETER)
+                    {
+                        config_stageParameter(commandIndex, received.parameters[1]);
+                    }
+                    addByte(commandIndex);
+                    addWord(config_getParameter(commandIndex));
+                    addWord(config_getStagedParameter(commandIndex));
+                    break;
+
+                case eCOMMAND_WRITE_CONFIG:
+                    if (commandValue == 0)
+                    {
+                        config_discard();
+                    }
+                    else if (commandValue == 1)
+                    {
+                        config_commit();
+                    }
+                    addByte(config_staged());
+                    addByte(config_writing());
+                    addByte(config_stored());
+                    addWord(config_getSequence());
+                    break;
+
+                case eCOMMAND_SET_PULL_IN_SCHEDULE:
+                    ioHandler_setPullInSchedule(received.parameters[0], received.parameters[1]);
+                    addByte(received.parameters[0]);
+                    addWord(received.parameters[1]);
+                    break;
+
+                case eCOMMAND_GET_COUNTER:
+                {
+                    inputCounter_t counter;
+                    ioHandler_getCounter(commandIndex, &counter);
+                    addByte(commandIndex);
+                    addLong(counter.count);
+                    addLong(counter.gateCount);
+                    addLong(counter.frequency);
+                    break;
+                }
+
+                case eCOMMAND_GET_CAPABILITIES:
+                    for (uint8_t rateIndex = 0; rateIndex < sizeof(supportedBaudRates) / sizeof(supportedBaudRates[0]); rateIndex++)
+                    {
+                        addWord(supportedBaudRates[rateIndex]);
+                    }
                     break;
 
                 default:
@@ -526,43 +1713,176 @@ static void handleRequest(char *received)
 
             // no error so increment frame number since for the current frame number a valid message has been received
             nextExpectedFrameNumber++;
+            resynchronizing = false;
+
+            // a valid request has been received with the new baud rate, so keep it
+            if (baudRateState == eBAUD_RATE_UNCONFIRMED)
+            {
+                baudRateState = eBAUD_RATE_CONFIRMED;
+            }
         }
-        index = addInteger(response, index, crc16X25(response, index));
+        finishResponse();
     }
-    else
+
+    transferMode = requestedTransferMode;
+}
+
+// take the service time of all responses that have left the UART completely
+static void handleSentResponses(void)
+{
+    while (sendingCount && uart_transmitted(sendingResponses[sendingHead].position))
     {
-        P2(">>>>overflow\n");
-        uint16_t index = 0;
-        index = addInteger(response, index, nextExpectedFrameNumber);
-        index = addChar(response, index, eCOMMAND_NACK);
-        index = addInteger(response, index, eMESSAGE_ERROR_OVERFLOW);
-        index = addInteger(response, index, crc16X25(response, index));
+        uint16_t service = timer_getStamp() - sendingResponses[sendingHead].receiveStamp;
+        countUp(&allLatencies.service[latencyBucket(service >> eSERVICE_BUCKET_SHIFT)]);
+        if (sendingResponses[sendingHead].selected)
+        {
+            countUp(&commandLatencies.service[latencyBucket(service >> eSERVICE_BUCKET_SHIFT)]);
+        }
+        sendingHead = (sendingHead + 1) % eMAX_WINDOW_SIZE;
+        sendingCount--;
     }
-    P2("<<<<%s\n\n", response);
-    Serial.println(response);
 }
 
-// processes received byte
-void messageHandler_receivedChar(char byte)
+// execute a complete request and take its queueing delay, its service time is taken as soon as the response has been sent
+static void executeRequest(void)
+{
+    uint16_t receiveStamp;
+    bool stamped = uart_getReceiveStamp(&receiveStamp);
+    uint16_t startStamp = timer_getStamp();
+
+    responded = false;
+    handleRequest();
+
+    // requests dropped without a response and the ones whose line end couldn't be stamped are not measured
+    if (stamped && responded)
+    {
+        bool selected = received.descriptor && (received.descriptor->command == latencyCommand);
+        uint16_t queueing = startStamp - receiveStamp;
+        countUp(&allLatencies.queueing[latencyBucket(queueing >> eQUEUEING_BUCKET_SHIFT)]);
+        if (selected)
+        {
+            countUp(&commandLatencies.queueing[latencyBucket(queueing >> eQUEUEING_BUCKET_SHIFT)]);
+        }
+
+        handleSentResponses();
+        if (sendingCount < eMAX_WINDOW_SIZE)
+        {
+            uint8_t entry = (sendingHead + sendingCount) % eMAX_WINDOW_SIZE;
+            sendingResponses[entry].position     = uart_transmitPosition();
+            sendingResponses[entry].receiveStamp = receiveStamp;
+            sendingResponses[entry].selected     = selected;
+            sendingCount++;
+        }
+    }
+    resetRequest();
+}
+
+// processes received byte of a COBS encoded binary request
+static void receivedBinaryChar(char byte)
 {
-    if (requestIndex >= eMAX_REQUEST_LENGTH)
+    if (byte == '\0')
     {
-        // synchronize to next NL (or NUL)
-        if ((byte == '\n') || (byte == '\0'))
+        // frame delimiter, request complete (empty frames are ignored, so a delimiter can be sent to resynchronize)
+        if (received.cobsCode)
         {
-            // throw all received data away...
-            handleRequest(NULL);
-            requestIndex = 0;
+            executeRequest();
         }
     }
-    else if ((byte != '\n') && (byte != '\0'))
+    else if (received.cobsRemaining)
     {
-        request[requestIndex++] = byte;
+        parseBinaryChar(byte);
+        received.cobsRemaining--;
     }
     else
     {
-        request[requestIndex] = '\0';
-        handleRequest(request);
-        requestIndex = 0;
+        // new COBS block, previous block (if there was one) ends with a zero except it had maximum length
+        if (received.cobsCode && (received.cobsCode != 0xFF))
+        {
+            parseBinaryChar('\0');
+        }
+        received.cobsCode = byte;
+        received.cobsRemaining = received.cobsCode - 1;
+    }
+}
+
+// processes received byte
+static void receivedChar(char byte)
+{
+    if (transferMode == eTRANSFER_MODE_BINARY)
+    {
+        receivedBinaryChar(byte);
+    }
+    else if ((byte == '\n') || (byte == '\0'))
+    {
+        // request complete, everything has been parsed already so just execute it and respond
+        executeRequest();
+    }
+    else
+    {
+        parseChar(byte);
+    }
+}
+
+
+// switch baud rate after confirmation has been sent and fall back to default baud rate if new one doesn't work
+static void handleBaudRate(void)
+{
+    switch (baudRateState)
+    {
+        case eBAUD_RATE_SWITCH_PENDING:
+            if (uart_transmitCompleted())
+            {
+                uart_setup((uint32_t)requestedBaudRate * eBAUD_RATE_UNIT);
+                resetRequest();                     // throw away everything received with the old baud rate
+                sendingCount = 0;                   // everything has been sent, UART positions restart
+                baudRateSwitchTicks = timer_getTicks();
+                baudRateState = (requestedBaudRate == config_getParameter(eCONFIG_BAUD_RATE)) ? eBAUD_RATE_CONFIRMED : eBAUD_RATE_UNCONFIRMED;     // default baud rate needs no confirmation
+            }
+            break;
+
+        case eBAUD_RATE_UNCONFIRMED:
+            if ((timer_getTicks() - baudRateSwitchTicks) >= eBAUD_RATE_CONFIRMATION_TIMEOUT)
+            {
+                // no valid request received in time, fall back to default baud rate (as soon as everything has been sent) and ASCII mode
+                requestedBaudRate = config_getParameter(eCONFIG_BAUD_RATE);
+                transferMode = requestedTransferMode = eTRANSFER_MODE_ASCII;
+                resetRequest();
+                baudRateState = eBAUD_RATE_SWITCH_PENDING;
+            }
+            break;
+    }
+}
+
+
+// send the next input event that hasn't been sent so far (one per call, so requests are not delayed by a burst of events), if there
+// were too many of them the oldest ones are lost (the host sees the gap in the sequence numbers and can request them as long as they are buffered)
+static void sendEvent(void)
+{
+    inputEvent_t event;
+    if (eventsEnabled && (baudRateState == eBAUD_RATE_CONFIRMED) && ioHandler_getEvent(nextEventToSend, &event))
+    {
+        startResponse();
+        addFrameNumber(nextExpectedFrameNumber);
+        addChar(eCOMMAND_EVENT);
+        addWord(event.sequence);
+        addByte(event.inputs);
+        addLong(event.ticks);
+        finishResponse();
+        nextEventToSend = event.sequence + 1;
+    }
+}
+
+
+// processes all bytes received so far
+void messageHandler_cyclicTask(void)
+{
+    handleSentResponses();
+    handleBaudRate();
+    sendEvent();
+
+    char byte;
+    while (uart_receive(&byte))
+    {
+        receivedChar(byte);
     }
 }
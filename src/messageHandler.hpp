@@ -9,11 +9,16 @@
 
 /**
     GENERAL:    "<fno>;<cmd>;<payload>;<crc>;\n"
+                commands are case sensitive
 
     WATCHDOG:
         request:  "<fno>;W;<state>;<crc>;\n"
         response: "<fno>;W;<oldState>;<newState>;<lockState>;<crc>;\n"
 
+    HEARTBEAT (watchdog with status):
+        request:  "<fno>;H;<state>;<crc>;\n"
+        response: "<fno>;H;<oldState>;<newState>;<lockState>;<inputs>;<outputs>;<wdCounter>;<testState>;<testTime>;<pending>;<crc>;\n"
+
     SET OUTPUT:
         request:  "<fno>;S;<output>;<state>;<crc>;\n"
         response: "<fno>;S;<output>;<oldState>;<newState>;<crc>;\n"
@@ -34,18 +39,287 @@
         request:  "<fno>;T;<crc>;\n"
         response: "<fno>;T;<requestAccepted>;<crc>;\n"
 
+    SET BAUD RATE:
+        request:  "<fno>;B;<baudRate>;<crc>;\n"
+        response: "<fno>;B;<baudRate>;<crc>;\n"
+                  response is sent with the current baud rate, afterwards the new one is used, if no valid request has been received with the
+                  new baud rate within 2 seconds the board falls back to the configured baud rate (9600 baud per default) (frame numbers are not affected by a baud rate change)
+
+    GET CAPABILITIES:
+        request:  "<fno>;C;<crc>;\n"
+        response: "<fno>;C;<baudRate>;...;<baudRate>;<crc>;\n"
+
+    SET TRANSFER MODE:
+        request:  "<fno>;X;<mode>;<crc>;\n"
+        response: "<fno>;X;<mode>;<crc>;\n"
+                  response is sent in the current mode, afterwards the new mode is used for requests and responses
+
+    SET OUTPUTS:
+        request:  "<fno>;M;<outputs>;<mask>;<crc>;\n"
+        response: "<fno>;M;<oldOutputs>;<newOutputs>;<delay>;<crc>;\n"
+                  all outputs set in mask are changed within the same tick (unless the pull-in schedule delays switching ON), mask 0
+                  changes nothing (use 127 to set all outputs)
+
+    READ ALL:
+        request:  "<fno>;A;<crc>;\n"
+        response: "<fno>;A;<inputs>;<outputs>;<crc>;\n"
+
+    SET WINDOW SIZE:
+        request:  "<fno>;N;<windowSize>;<crc>;\n"
+        response: "<fno>;N;<windowSize>;<crc>;\n"
+                  the host may send up to windowSize requests without waiting for their responses, they are processed and responded in
+                  order with their own frame numbers; after a NACK all requests within the window behind the expected frame number are
+                  dropped without a response until the request with the expected frame number has been received again (go-back-N)
+
+    SET INPUT FILTER:
+        request:  "<fno>;F;<input>;<filter>;<rise>;<fall>;<crc>;\n"
+        response: "<fno>;F;<input>;<filter>;<rise>;<fall>;<crc>;\n"
+                  filters are applied to the 1ms samples, input 0 (watchdog readback) can't be filtered, all inputs are unfiltered after startup
+
+    ENABLE EVENTS:
+        request:  "<fno>;J;<enable>;<crc>;\n"
+        response: "<fno>;J;<enable>;<sequence>;<crc>;\n"
+                  sequence is the sequence number the next input change will get, if enabled each input change is sent unsolicited as
+                  "<fno>;I;<sequence>;<inputs>;<ticks>;<crc>;\n" (fno is the expected frame number, events don't use frame numbers)
+
+    GET EVENT:
+        request:  "<fno>;G;<sequence>;<crc>;\n"
+        response: "<fno>;G;<available>;<sequence>;<inputs>;<ticks>;<crc>;\n"
+                  returns the requested event or if it has been overwritten already the oldest buffered one (the last 16 events are buffered),
+                  available is the number of events from the returned one up to the latest one, 0 if the requested event hasn't happened yet
+
+    ENABLE EDGE CAPTURE:
+        request:  "<fno>;K;<enable>;<crc>;\n"
+        response: "<fno>;K;<enable>;<crc>;\n"
+                  if enabled each change of an input pin is captured by pin change interrupt with a timestamp (even pulses shorter than
+                  1ms), enabling or disabling clears all captured edges
+
+    GET EDGES:
+        request:  "<fno>;Q;<remove>;<crc>;\n"
+        response: "<fno>;Q;<lost>;<captured>;<count>;<ticks>;<us>;<inputs>;...;<ticks>;<us>;<inputs>;<crc>;\n"
+                  first the oldest <remove> edges are removed (the ones the host has received with the previous response), afterwards
+                  the oldest <count> (up to 4) of the <captured> edges are responded without removing them, so a lost response can be
+                  requested again with remove = 0
+
+    SET TIMED OUTPUT:
+        request:  "<fno>;P;<output>;<state>;<duration>;<crc>;\n"
+        response: "<fno>;P;<output>;<oldState>;<newState>;<duration>;<crc>;\n"
+                  output is set for duration ms (with tick accuracy) and reverts to its state before afterwards, duration 0 cancels a
+                  timed output (output keeps its current state), setting the output with 'S' or 'M' cancels it as well; while switching
+                  ON is delayed by the pull-in schedule ('O') the duration doesn't elapse, so the output is ON for the full duration
+                  and reverts correspondingly later
+
+    GET TIMED OUTPUT:
+        request:  "<fno>;p;<output>;<crc>;\n"
+        response: "<fno>;p;<output>;<state>;<remaining>;<revertState>;<crc>;\n"
+
+    SET SEQUENCE STEP:
+        request:  "<fno>;U;<step>;<mask>;<outputs>;<duration>;<crc>;\n"
+        response: "<fno>;U;<step>;<mask>;<outputs>;<duration>;<crc>;\n"
+                  the outputs in mask are set to outputs when the step starts, the next step starts after duration ms, steps can't be
+                  changed while the sequence is running (error 10)
+
+    GET SEQUENCE STEP:
+        request:  "<fno>;u;<step>;<crc>;\n"
+        response: "<fno>;u;<step>;<mask>;<outputs>;<duration>;<crc>;\n"
+
+    RUN SEQUENCE:
+        request:  "<fno>;r;<action>;<steps>;<crc>;\n"
+        response: "<fno>;r;<sequenceState>;<step>;<remaining>;<crc>;\n"
+                  steps 0..steps-1 are executed one after the other by the cyclic task (the first one with the next tick), afterwards
+                  the outputs keep their states; if the watchdog stops running the sequence is aborted and all outputs used by it so
+                  far are switched OFF; setting an output with 'S', 'M' or 'P' while the sequence is running is possible but the next
+                  step overwrites it again if it's in its mask; outputs switched ON by a step are not delayed by the pull-in schedule
+                  ('O') to keep the step timing, so the sequence isn't started if one of its steps switches ON more than maxPullIns
+                  outputs (error 10), the outputs count for the current window though, so other outputs may wait longer
+
+    SET OUTPUT PROFILE:
+        request:  "<fno>;L;<output>;<pullInTime>;<holdDuty>;<crc>;\n"
+        response: "<fno>;L;<output>;<pullInTime>;<holdDuty>;<crc>;\n"
+                  after switching ON an output is driven fully for the pull-in time and afterwards with a 20kHz PWM of the hold duty to
+                  reduce the coil current, only outputs 3..6 can be held (outputs 0..2 are pulsed), a hold duty needs a pullInTime > 0
+                  (error 5), the hold duty is shared by all held outputs, so a different duty is rejected while another output is held
+                  (error 10, set that output to holdDuty 0 first)
+
+    SET OUTPUT CONFIGURATION:
+        request:  "<fno>;o;<output>;<pulsed>;<pulsePeriod>;<crc>;\n"
+        response: "<fno>;o;<output>;<pulsed>;<pulsePeriod>;<stored>;<crc>;\n"
+                  the configuration is stored in EEPROM and loaded at startup, it can only be changed while the watchdog is not running
+                  and no configuration is being written (error 10), an output that gets pulsed loses its hold PWM (see 'L'), all pulsed
+                  outputs restart synchronized, staged parameters (see 's') are discarded
+
+    GET OUTPUT CONFIGURATION:
+        request:  "<fno>;g;<output>;<crc>;\n"
+        response: "<fno>;g;<output>;<pulsed>;<pulsePeriod>;<stored>;<crc>;\n"
+
+    GET PARAMETER:
+        request:  "<fno>;c;<parameter>;<crc>;\n"
+        response: "<fno>;c;<parameter>;<value>;<stagedValue>;<crc>;\n"
+
+    STAGE PARAMETER:
+        request:  "<fno>;s;<parameter>;<value>;<crc>;\n"
+        response: "<fno>;s;<parameter>;<value>;<stagedValue>;<crc>;\n"
+                  the parameter is changed in the staged configuration only, it becomes active with commit ('w')
+
+    WRITE CONFIGURATION:
+        request:  "<fno>;w;<action>;<crc>;\n"
+        response: "<fno>;w;<pending>;<writing>;<stored>;<configSequence>;<crc>;\n"
+                  commit makes the staged configuration the active one and writes it in the background to the next record of an EEPROM
+                  ring (16 records, the latest one with a valid CRC is loaded at startup, defaults are used if there is none), commit is
+                  only possible while the watchdog is not running and no configuration is being written (error 10), the baud rate is
+                  used after the next startup or baud rate fallback
+
+    GET STATISTICS:
+        request:  "<fno>;d;<page>;<reset>;<crc>;\n"
+        response: "<fno>;d;<page>;<pages>;<counters>;<crc>;\n"
+                  page 0: <receivedFrames>;<sentFrames>;<replayed>;<dropped>;<discardedBytes>;<overruns>;<framingErrors>;<rxOverflows>
+                  page 1: <nacks>;...;<nacks> for err 1, 2, ... (one counter per error number)
+                  page 2: <ticks>;<minExec>;<meanExec>;<maxExec>;<minLatency>;<meanLatency>;<maxLatency>;<tickOverruns>;<isrLoad>;<idleLoops>;<maxIdleLoops>
+                  page 3: <minFreeRam>;<freeRam>;<lowRamThreshold>
+                  page 4..pages-1: <count>;<cmd>;<executed>;...;<cmd>;<executed> (up to 8 commands per page)
+                  all counters saturate, with reset = 1 the counters of the responded page are cleared afterwards
+
+    GET HISTORY:
+        request:  "<fno>;h;<sequence>;<crc>;\n"
+        response: "<fno>;h;<nextSequence>;<lostEntries>;<continueSequence>;<count>;<sequence>;<boot>;<ticks>;<type>;<code>;...;<crc>;\n"
+                  errors (a recurring error is logged once a minute at most), watchdog state changes, passed self tests and
+                  startups are logged with boot counter and uptime in an EEPROM ring of the last 32 entries that survives a reset, up
+                  to 3 entries starting at the requested sequence number (or the oldest kept one) are responded, the host continues
+                  with continueSequence until it reaches nextSequence
+
+    GET REQUEST LATENCIES:
+        request:  "<fno>;l;<command>;<reset>;<crc>;\n"
+        response: "<fno>;l;<command>;<queueing>;...;<queueing>;<service>;...;<service>;<crc>;\n"
+                  log2 histograms (8 buckets each) of the device side latencies of all requests or of a single command, the queueing
+                  delay is measured from receiving the line end (frame delimiter) until the request is processed, the service time until
+                  the last response byte has left the UART, both with 16us resolution, requests without a response are not measured,
+                  selecting another command restarts its histograms, with reset = 1 the responded histograms are cleared afterwards
+
+    SET PULL-IN SCHEDULE:
+        request:  "<fno>;O;<maxPullIns>;<gap>;<crc>;\n"
+        response: "<fno>;O;<maxPullIns>;<gap>;<crc>;\n"
+                  at most maxPullIns outputs are switched ON within gap (also when the watchdog starts running), further outputs wait
+                  and are switched ON in index order, switching OFF is never delayed, maxPullIns 0 means no limit (default), outputs
+                  switched ON by a sequence step ('r') are never delayed, the schedule can't be changed while the sequence is running
+                  (error 10)
+
+    SET COUNTER:
+        request:  "<fno>;Z;<input>;<gateTime>;<crc>;\n"
+        response: "<fno>;Z;<input>;<gateTime>;<crc>;\n"
+                  rising edges of inputs 1..3 are counted by interrupt (input 1 by INT1, inputs 2 and 3 by pin change interrupt), the
+                  frequency is measured over the gate time, gate time 0 disables the counter, counter is restarted with each request
+
+    GET COUNTER:
+        request:  "<fno>;Y;<input>;<crc>;\n"
+        response: "<fno>;Y;<input>;<count>;<gateCount>;<frequency>;<crc>;\n"
+
     ERROR:
         request:  "<damaged>;\n"
         response: "<expectedFNo>;E;<err>;[<request>];<crc>;\n"
                   if the '\n' was damaged then the error response will be sent as soon as a '\n' has been detected and first n characters of damaged request are responded
 
+    RETRANSMISSION:
+        the responses of the last 4 executed requests are cached, a request that is identical to one of them (same frame number and CRC)
+        gets the cached response again instead of an error response, the command is not executed a second time (responses longer than
+        48 characters are not cached)
+
     fno ............. 0..255 is the frame number that has to be incremented with each telegram
     output .......... 0..6 (watchdog is not an output!)
     input ........... 0..3
     state ........... 0,1
-    diagnosis ....... 16 bit diagnosis collected since last "get diagnosis" command
+    diagnosis ....... 16 bit diagnosis collected since last "get diagnosis" command, bit 0 = startup, bit 1 = low stack (minFreeRam
+                      has fallen below lowRamThreshold, set again with each main loop pass as long as it is)
     firstError ...... first detected error since last "get diagnosis" command
     executedTests ... executed self tests since last "get diagnosis" command
+    baudRate ........ baud rate in 100 baud steps, supported are 96 (default), 576, 1152, 2500, 5000, 10000
+    mode ............ 0 = ASCII (default), 1 = binary
+    outputs ......... 0..127 bit mask of output states, bit 0 is output 0
+    mask ............ 0..127 bit mask of outputs to be changed, bit 0 is output 0
+    inputs .......... 0..15 bit mask of input states, bit 0 is input 0
+    wdCounter ....... remaining ms until watchdog has to be triggered again
+    testState ....... self test state, 0 = initial, 1 = repeated (expect ON), 2 = repeated (expect OFF), 3 = passed, 4 = failed
+    testTime ........ remaining ms until next self test has to be requested
+    windowSize ...... 1 (default, lock-step) .. 8 requests in flight, all requests in flight have to fit into the 128 bytes RX buffer
+    filter .......... 0 = none (default), 1 = consecutive samples, 2 = majority vote over the last 8 samples, 3 = integrating counter
+    rise ............ samples needed to switch an input ON: consecutive ON samples (1), ON samples out of 8 (2), ON minus OFF samples (3)
+    fall ............ samples needed to switch an input OFF, like rise, for majority vote rise + fall has to be larger than 8
+    enable .......... 0 = disabled (default), 1 = enabled
+    sequence ........ 0..65535 sequence number of an input change event, incremented with each change, or of a history entry ('h')
+    ticks ........... ms since startup when the input change has been detected
+    remove .......... 0..32 number of edges to be removed
+    lost ............ edges lost since edge capture has been enabled because 31 edges were captured already
+    captured ........ edges captured and not removed so far
+    us .............. us since <ticks> when the edge has been captured in 4us steps, <ticks>;<us> is the timestamp of the edge
+    duration ........ 0..65535 ms an output is set by a timed output ('P') or 1..65535 ms of a sequence step ('U')
+    remaining ....... ms until a timed output reverts, 0 = output isn't timed ('p') or until the current sequence step is over ('r')
+    revertState ..... state a timed output reverts to
+    step ............ 0..7 index of a sequence step, in the response of 'r' the current (or last executed) step
+    steps ........... 1..8 number of sequence steps to be executed (ignored by stop and status)
+    sequenceState ... 0 = idle, 1 = running, 2 = finished, 3 = aborted (watchdog stopped running)
+    pulsed .......... 0 = output is switched ON, 1 = output is toggled every pulse period (default for outputs 0..2)
+    pulsePeriod ..... 1..100 ms between two toggles of a pulsed output, 1 = default
+    stored .......... 1 if the active configuration is stored in EEPROM, 0 = defaults are used or the configuration is being written
+    parameter ....... 0 = watchdog time (1000..60000 ms, 60000 = default)
+                      1 = reset lock time (10000..60000 ms, 30000 = default)
+                      2 = self test timeout (1000..60000 ms, 10000 = default)
+                      3 = self test repeat time (1..6000 minutes, 6000 = default)
+                      4 = LED toggle time while watchdog is running (50..10000 ms, 2000 = default)
+                      5 = LED toggle time in watchdog error state (50..10000 ms, 100 = default)
+                      6 = baud rate after startup and fallback baud rate (a supported baudRate, 96 = default)
+    value ........... 0..65535 active value of a parameter
+    stagedValue ..... 0..65535 value of a parameter that becomes active with the next commit
+    action .......... 0 = stop (outputs keep their states), 1 = start with step 0, 2 = status ('r')
+                      0 = discard staged parameters, 1 = commit, 2 = status ('w')
+    page ............ statistics page, see pages in the response
+    reset ........... 0 = keep counters, 1 = clear the responded counters
+    receivedFrames .. 32 bit number of complete requests including damaged ones
+    sentFrames ...... 32 bit number of responses, NACKs and events
+    replayed ........ retransmitted requests answered from the response cache
+    dropped ......... requests in flight dropped without a response after a NACK
+    discardedBytes .. bytes ignored behind the first error of a request
+    overruns ........ UART data overruns, bytes have been lost because the receiver wasn't read in time
+    framingErrors ... bytes with an invalid stop bit, usually a baud rate mismatch or a noisy line
+    rxOverflows ..... bytes thrown away because the RX buffer was full
+    nacks ........... NACKs sent for an error number
+    cmd ............. command character (binary: one byte)
+    executed ........ successfully executed requests of a command
+    ticks ........... 32 bit number of cyclic task runs (1ms ticks) measured
+    minExec ......... shortest execution time of the cyclic task in us (4us resolution)
+    meanExec ........ mean execution time of the cyclic task in us (older samples fade out after ~70 minutes)
+    maxExec ......... longest execution time of the cyclic task in us
+    minLatency ...... shortest delay between the timer compare match and the start of the cyclic task in us
+    meanLatency ..... mean delay of the cyclic task start in us, max - min is the jitter of the tick
+    maxLatency ...... longest delay of the cyclic task start in us, interrupts blocked by other code show up here
+    tickOverruns .... cyclic task runs longer than a tick, the following tick was delayed
+    isrLoad ......... 0..1000 per mille of the CPU time spent in the cyclic task
+    idleLoops ....... 32 bit number of main loop passes within the last second
+    maxIdleLoops .... 32 bit highest number of main loop passes within a second since startup,
+                      CPU load = 1 - idleLoops / maxIdleLoops (idle loop values aren't cleared by reset)
+    minFreeRam ...... smallest number of bytes between heap and stack since startup (stack high-water mark, not cleared by reset)
+    freeRam ......... current number of bytes between heap and stack
+    lowRamThreshold . minFreeRam below this number of bytes sets the low stack diagnosis
+    command ......... 0 = latencies of all requests, otherwise the character code of a command (e.g. 86 for 'V')
+    queueing ........ requests with a queueing delay below 32us, 64us, 128us, 256us, 512us, 1ms, 2ms and above 2ms
+    service ......... responses with a service time below 512us, 1ms, 2ms, 4ms, 8ms, 16ms, 32ms and above 32ms
+    nextSequence .... sequence number the next history entry will get
+    lostEntries ..... history entries lost since startup because the EEPROM couldn't be written fast enough
+    continueSequence  sequence number to be requested next, it's nextSequence if all entries have been responded
+    boot ............ 0..65535 boot counter, incremented with each startup
+    type ............ history entry type, 0 = startup, 1 = error (code = firstError number), 2 = watchdog state (code = 1 running, 2 error), 3 = self test passed
+    code ............ depends on the history entry type
+    pending ......... 1 if staged parameters differ from the active ones
+    writing ......... 1 while a configuration is being written to EEPROM (~3.3ms per changed byte)
+    configSequence .. 0..65535 sequence number of the active configuration record, 0 = defaults
+    pullInTime ...... 0..10000 ms with full drive after switching an output ON
+    holdDuty ........ 0..99 % PWM duty after pull-in (needs a pullInTime > 0), 0 = full drive (default)
+    maxPullIns ...... 0..7 outputs switched ON within a gap, 0 = no limit
+    gap ............. 1..10000 ms between pull-ins of the next outputs
+    delay ........... ms until the last output set to ON will be switched ON by the pull-in schedule, 0 = with the next tick
+    gateTime ........ 0..60000 ms gate time of the frequency measurement, 0 = counter disabled
+    count ........... rising edges since the counter has been enabled
+    gateCount ....... rising edges within the last complete gate time
+    frequency ....... frequency in mHz measured over the last complete gate time, 0 until the first gate time has elapsed
+    pending ......... 1 if "get diagnoses" would return any error, diagnosis or executed test, 0 otherwise
     crc ............. CRC16 X25
     err ............. error number
     damaged ......... damaged request or maybe even more than one request if '\n' was damaged
@@ -53,6 +327,60 @@
 
     semicolon in front of CRC is included in CRC but the CRC and the following semicolon is not but it's expected and, therefore, also protected!
 
+    BINARY MODE:
+        frame:    COBS(<fno><cmd><payload><crc>) 0x00
+                  fno is a single byte (lower 8 bits of the frame number), cmd is the command character, crc is the CRC16 X25 over fno, cmd
+                  and payload (little endian), the whole frame is COBS encoded and terminated by a 0x00 byte, empty frames are ignored
+        payload:  all fields of the ASCII request/response in the same order with fixed width (w = 16 bit little endian, all others 8 bit),
+                  there are no semicolons and no line end
+                    W  request: <state>                         response: <oldState><newState><lockState>
+                    H  request: <state>                         response: <oldState><newState><lockState><inputs><outputs><wdCounter:w><testState>
+                                                                          <testTime:l><pending>   (l = 32 bit little endian)
+                    S  request: <output><state>                 response: <output><oldState><newState>
+                    R  request: <input>                         response: <input><state>
+                    V  request: -                               response: <version> (characters without terminator)
+                    D  request: -                               response: <diagnosis:w><firstError:w><executedTests:w>
+                    T  request: -                               response: <requestAccepted>
+                    B  request: <baudRate:w>                    response: <baudRate:w>
+                    C  request: -                               response: <baudRate:w>...<baudRate:w>
+                    X  request: <mode>                          response: <mode>
+                    M  request: <outputs><mask>                 response: <oldOutputs><newOutputs><delay:w>
+                    A  request: -                               response: <inputs><outputs>
+                    N  request: <windowSize>                    response: <windowSize>
+                    F  request: <input><filter><rise><fall>     response: <input><filter><rise><fall>
+                    K  request: <enable>                        response: <enable>
+                    Q  request: <remove>                        response: <lost:w><captured><count>{<ticks:l><us:w><inputs>}*count
+                    P  request: <output><state><duration:w>     response: <output><oldState><newState><duration:w>
+                    p  request: <output>                        response: <output><state><remaining:w><revertState>
+                    U  request: <step><mask><outputs><duration:w>  response: <step><mask><outputs><duration:w>
+                    u  request: <step>                          response: <step><mask><outputs><duration:w>
+                    r  request: <action><steps>                 response: <sequenceState><step><remaining:w>
+                    o  request: <output><pulsed><pulsePeriod>   response: <output><pulsed><pulsePeriod><stored>
+                    g  request: <output>                        response: <output><pulsed><pulsePeriod><stored>
+                    c  request: <parameter>                     response: <parameter><value:w><stagedValue:w>
+                    s  request: <parameter><value:w>            response: <parameter><value:w><stagedValue:w>
+                    w  request: <action>                        response: <pending><writing><stored><configSequence:w>
+                    d  request: <page><reset>                   response: <page><pages><receivedFrames:l><sentFrames:l><replayed:w><dropped:w>
+                                                                          <discardedBytes:w><overruns:w><framingErrors:w><rxOverflows:w>   (page 0)
+                                                                          <page><pages><nacks:w>*10   (page 1)
+                                                                          <page><pages><ticks:l><minExec:w><meanExec:w><maxExec:w><minLatency:w>
+                                                                          <meanLatency:w><maxLatency:w><tickOverruns:w><isrLoad:w>
+                                                                          <idleLoops:l><maxIdleLoops:l>   (page 2)
+                                                                          <page><pages><minFreeRam:w><freeRam:w><lowRamThreshold:w>   (page 3)
+                                                                          <page><pages><count>{<cmd><executed:w>}*count   (further pages)
+                    h  request: <sequence:w>                    response: <nextSequence:w><lostEntries:w><continueSequence:w><count>
+                                                                          {<sequence:w><boot:w><ticks:l><type><code:w>}*count
+                    l  request: <command><reset>                response: <command><queueing:w>*8<service:w>*8
+                    L  request: <output><pullInTime:w><holdDuty>  response: <output><pullInTime:w><holdDuty>
+                    O  request: <maxPullIns><gap:w>             response: <maxPullIns><gap:w>
+                    Z  request: <input><gateTime:w>             response: <input><gateTime:w>
+                    Y  request: <input>                         response: <input><count:l><gateCount:l><frequency:l>
+                    J  request: <enable>                        response: <enable><sequence:w>
+                    G  request: <sequence:w>                    response: <available><sequence:w><inputs><ticks:l>
+                    I  (event, unsolicited)                     <sequence:w><inputs><ticks:l>
+                    E  request: -                               response: <err><crc:w> (damaged request is not responded)
+                  if no valid request has been received after a baud rate change the board falls back to the configured baud rate and ASCII mode
+
     to test either set IGNORE_CRC validation in debug.hpp or use a page for proper calculation of CRC16-X25, e.g. https://crccalc.com
 
     examples:
@@ -99,7 +427,7 @@
 */
 
 
-void messageHandler_receivedChar(char byte);
+void messageHandler_cyclicTask(void);
 
 
 #endif
@@ -0,0 +1,100 @@
+#include <Arduino.h>
+#include <stdint.h>
+#include "stackMonitor.hpp"
+#include "errorAndDiagnosis.hpp"
+
+
+extern uint8_t __heap_start;        // end of .bss and start of the heap (linker symbol)
+extern void   *__brkval;            // end of the heap, NULL as long as malloc() has never been used
+
+enum
+{
+    eSTACK_PAINT = 0xC5,            // pattern of stack bytes that have never been used
+    eSTACK_PAINT_MARGIN = 8,        // bytes below the stack pointer that are not painted (return address of the painting function)
+    eSTACK_SCAN_BYTES = 16,         // bytes compared per check, a complete scan is spread over several checks
+};
+
+static uint8_t *highWaterMark;      // lowest stack address that has been used so far, everything below is still painted
+static uint8_t *scanAddress;        // next byte compared by the running scan
+
+
+// the stack must not grow below the end of the heap
+static inline uint8_t *heapEnd(void)
+{
+    return __brkval ? (uint8_t *)__brkval : &__heap_start;
+}
+
+
+/**
+ * @brief Paint the unused RAM between heap and stack, to be called at the very beginning of the setup
+ */
+void stackMonitor_setup(void)
+{
+    uint8_t *address = heapEnd();
+    highWaterMark = (uint8_t *)(SP - eSTACK_PAINT_MARGIN);
+    scanAddress = address;
+    while (address < highWaterMark)
+    {
+        *address++ = eSTACK_PAINT;
+    }
+}
+
+
+/**
+ * @brief Update the stack high-water mark and set eDIAGNOSIS_LOW_STACK if the free RAM has fallen below eSTACK_LOW_THRESHOLD,
+ * to be called with each pass of the main loop (only eSTACK_SCAN_BYTES bytes are compared per call)
+ */
+void stackMonitor_check(void)
+{
+    uint8_t *end = heapEnd();
+    if (scanAddress < end)
+    {
+        scanAddress = end;
+    }
+
+    // locals that have never been written leave painted gaps within the used stack, so the mark is searched upwards from the heap,
+    // the painted bytes below the lowest used one are contiguous, the scan restarts when it has reached the mark
+    for (uint8_t count = 0; (count < eSTACK_SCAN_BYTES) && (scanAddress < highWaterMark); count++)
+    {
+        if (*scanAddress != eSTACK_PAINT)
+        {
+            highWaterMark = scanAddress;
+            break;
+        }
+        scanAddress++;
+    }
+    if (scanAddress >= highWaterMark)
+    {
+        scanAddress = end;
+    }
+
+    if (stackMonitor_getMinFree() < eSTACK_LOW_THRESHOLD)
+    {
+        errorAndDiagnosis_setDiagnoses(eDIAGNOSIS_LOW_STACK);
+    }
+}
+
+
+/**
+ * @brief Get the smallest gap between heap and stack since startup
+ *
+ * @return bytes between the end of the heap and the stack high-water mark
+ */
+uint16_t stackMonitor_getMinFree(void)
+{
+    uint8_t *end = heapEnd();
+    return (highWaterMark > end) ? (uint16_t)(highWaterMark - end) : 0;
+}
+
+
+/**
+ * @brief Get the current gap between heap and stack
+ *
+ * @return bytes between the end of the heap and the stack pointer
+ */
+uint16_t stackMonitor_getFree(void)
+{
+    uint8_t *end = heapEnd();
+    uint8_t *stack = (uint8_t *)SP;
+    return (stack > end) ? (uint16_t)(stack - end) : 0;
+}
@@ -0,0 +1,20 @@
+#if not defined STACK_MONITOR_H
+#define STACK_MONITOR_H
+
+
+#include <stdint.h>
+
+
+enum
+{
+    eSTACK_LOW_THRESHOLD = 64,      // bytes that have to be left between heap and stack, otherwise eDIAGNOSIS_LOW_STACK is set
+};
+
+
+void     stackMonitor_setup(void);
+void     stackMonitor_check(void);
+uint16_t stackMonitor_getMinFree(void);
+uint16_t stackMonitor_getFree(void);
+
+
+#endif
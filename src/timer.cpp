@@ -1,11 +1,220 @@
 #include <Arduino.h>
+#include <util/atomic.h>
 #include "ioHandler.hpp"
 #include "timer.hpp"
 
 
+static volatile uint32_t tickCounter = 0;      // ticks since startup
+
+// cyclic task timing in timer counts, only written by the tick ISR
+enum
+{
+    eTICK_COUNTS = eTICK_VALUE + 1,         // timer counts per tick
+    eIDLE_PERIOD = 1000 / eTICK_TIME,       // idle loop passes are latched each second
+};
+static const uint32_t meanSamplesLimit = 1UL << 22;   // sums and their samples are halved when reached (~70 minutes), so the sums can't overflow
+typedef struct
+{
+    uint32_t samples;                   // saturates
+    uint32_t meanSamples;               // samples of the sums
+    uint32_t executionSum;
+    uint32_t latencySum;
+    uint16_t minExecution;
+    uint16_t maxExecution;
+    uint8_t  minLatency;
+    uint8_t  maxLatency;
+    uint16_t overruns;
+} timing_t;
+static timing_t timing = { 0, 0, 0, 0, 0xFFFF, 0, 0xFF, 0, 0 };
+
+static_assert(meanSamplesLimit <= 0xFFFFFFFFUL / 1000, "remainder of a sum times 1000 must fit into 32 bits");
+
+static volatile uint32_t idleCounter;      // main loop passes since startup
+static uint32_t idleLatched;                // idleCounter at the start of the current period
+static uint32_t idleLoops;                  // passes within the last complete period
+static uint32_t maxIdleLoops;
+static uint16_t idlePeriodTicks;
+
+
 ISR(TIMER1_COMPA_vect)
 {
+    uint8_t entryCount = TCNT1;         // compare match restarted the timer, so it's the latency of this ISR
+
+    tickCounter++;
     ioHandler_cyclicTask();
+
+    // OCF1A is set when TCNT1 reaches eTICK_VALUE and the restart follows with the next timer count, so TCNT1 has only been restarted
+    // if the flag was set before it has been read and it's below eTICK_VALUE, a flag set afterwards is an overrun as well
+    bool matched = timer_interruptSet();
+    uint16_t execution = (uint8_t)TCNT1;
+    if (matched && (execution != eTICK_VALUE))
+    {
+        execution += eTICK_COUNTS;
+    }
+    if ((matched || timer_interruptSet()) && (timing.overruns != 0xFFFF))
+    {
+        timing.overruns++;
+    }
+    execution -= entryCount;
+
+    if (timing.samples != 0xFFFFFFFF)
+    {
+        timing.samples++;
+    }
+    if (timing.meanSamples == meanSamplesLimit)
+    {
+        timing.meanSamples  >>= 1;
+        timing.executionSum >>= 1;
+        timing.latencySum   >>= 1;
+    }
+    timing.meanSamples++;
+    timing.executionSum += execution;
+    timing.latencySum   += entryCount;
+    if (execution < timing.minExecution)
+    {
+        timing.minExecution = execution;
+    }
+    if (execution > timing.maxExecution)
+    {
+        timing.maxExecution = execution;
+    }
+    if (entryCount < timing.minLatency)
+    {
+        timing.minLatency = entryCount;
+    }
+    if (entryCount > timing.maxLatency)
+    {
+        timing.maxLatency = entryCount;
+    }
+
+    // main loop passes per second give the CPU load relative to the least loaded second
+    if (++idlePeriodTicks >= eIDLE_PERIOD)
+    {
+        idlePeriodTicks = 0;
+        idleLoops   = idleCounter - idleLatched;
+        idleLatched = idleCounter;
+        if (idleLoops > maxIdleLoops)
+        {
+            maxIdleLoops = idleLoops;
+        }
+    }
+}
+
+
+/**
+ * @brief Get ticks since startup, can be called from main loop and from interrupt context
+ *
+ * @return elapsed ticks (eTICK_TIME ms each) since timer has been started
+ */
+uint32_t timer_getTicks(void)
+{
+    uint32_t ticks;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        ticks = tickCounter;
+    }
+    return ticks;
+}
+
+
+/**
+ * @brief Get a timestamp with sub tick resolution, to be called with interrupts disabled (e.g. from an ISR)
+ *
+ * @param counts    timer counts (eTIMER_COUNT_TIME us each) since the returned tick
+ *
+ * @return elapsed ticks (eTICK_TIME ms each) since timer has been started
+ */
+uint32_t timer_getTimestamp(uint8_t *counts)
+{
+    uint8_t count = TCNT1;
+    uint32_t ticks = tickCounter;
+
+    // timer has already been restarted but the tick ISR is still pending (a low count means the restart happened before TCNT1 has been read)
+    if ((TIFR1 & (1 << OCF1A)) && (count < eTICK_VALUE / 2))
+    {
+        ticks++;
+    }
+
+    *counts = count;
+    return ticks;
+}
+
+
+/**
+ * @brief Get a free running time stamp with eTIMER_STAMP_TIME resolution, it wraps around after ~1s so it's meant for measuring short
+ * intervals only (e.g. request latencies), can be called from an ISR as well
+ *
+ * @return time stamp in eTIMER_STAMP_TIME units
+ */
+uint16_t timer_getStamp(void)
+{
+    uint32_t ticks;
+    uint8_t counts;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        ticks = timer_getTimestamp(&counts);
+    }
+    return (ticks * eTICK_COUNTS + counts) / (eTIMER_STAMP_TIME / eTIMER_COUNT_TIME);
+}
+
+
+/**
+ * @brief Count a main loop pass for the CPU load measurement, to be called with each pass of the main loop
+ */
+void timer_idle(void)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        idleCounter++;
+    }
+}
+
+
+/**
+ * @brief Get the timing of the cyclic task and the CPU load
+ *
+ * @param statistics    timing values
+ * @param reset         restart the timing measurement (the idle loop measurement is never restarted)
+ */
+void timer_getStatistics(timerStatistics_t *statistics, bool reset)
+{
+    // only copy the raw values with interrupts disabled, the divisions take too long to delay the tick ISR
+    timing_t raw;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        raw = timing;
+        statistics->idleLoops    = idleLoops;
+        statistics->maxIdleLoops = maxIdleLoops;
+
+        if (reset)
+        {
+            timing.samples      = 0;
+            timing.meanSamples  = 0;
+            timing.executionSum = 0;
+            timing.latencySum   = 0;
+            timing.minExecution = 0xFFFF;
+            timing.maxExecution = 0;
+            timing.minLatency   = 0xFF;
+            timing.maxLatency   = 0;
+            timing.overruns     = 0;
+        }
+    }
+
+    // divide before multiplying so everything fits into 32 bits, the remainder is less than the samples (up to meanSamplesLimit)
+    uint32_t samples = raw.meanSamples ? raw.meanSamples : 1;
+    uint32_t meanExecution = raw.executionSum / samples;
+    uint32_t executionRest = raw.executionSum % samples;
+    uint32_t meanLatency   = raw.latencySum / samples;
+    uint32_t latencyRest   = raw.latencySum % samples;
+    statistics->samples       = raw.samples;
+    statistics->minExecution  = raw.samples ? raw.minExecution * eTIMER_COUNT_TIME : 0;
+    statistics->meanExecution = meanExecution * eTIMER_COUNT_TIME + executionRest * eTIMER_COUNT_TIME / samples;
+    statistics->maxExecution  = raw.maxExecution * eTIMER_COUNT_TIME;
+    statistics->minLatency    = raw.samples ? raw.minLatency * eTIMER_COUNT_TIME : 0;
+    statistics->meanLatency   = meanLatency * eTIMER_COUNT_TIME + latencyRest * eTIMER_COUNT_TIME / samples;
+    statistics->maxLatency    = raw.maxLatency * eTIMER_COUNT_TIME;
+    statistics->overruns      = raw.overruns;
+    statistics->isrLoad       = (meanExecution * 1000 + executionRest * 1000 / samples) / eTICK_COUNTS;
 }
 
 
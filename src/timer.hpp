@@ -8,9 +8,28 @@ enum
 {
     eTICK_TIME  = 1,       // 1ms (1ms is the shortest allowed possible tick time, otherwise cyclic io handler task will not work anymore!!!)
     eTICK_VALUE = (uint16_t)(((uint64_t)16*1000000 * eTICK_TIME) / ((uint64_t)64 * 1000)) - 1,   // x = ((16*10^6 * eTICK_TIME) / (64 * 1000)) - 1
+    eTIMER_COUNT_TIME = 4, // 4us per timer count (prescaler 64 at 16MHz)
+    eTIMER_STAMP_TIME = 16, // 16us per unit of timer_getStamp()
 };
 
 
+// timing of the cyclic task (tick ISR) and CPU load, times are given in us (with eTIMER_COUNT_TIME resolution)
+typedef struct
+{
+    uint32_t samples;               // ticks measured
+    uint16_t minExecution;          // time from ISR entry to exit
+    uint16_t meanExecution;
+    uint16_t maxExecution;
+    uint16_t minLatency;            // time from compare match to ISR entry (jitter of the cyclic task)
+    uint16_t meanLatency;
+    uint16_t maxLatency;
+    uint16_t overruns;              // ticks whose ISR took longer than a tick (next compare match happened before exit)
+    uint16_t isrLoad;               // per mille of the time spent in the tick ISR
+    uint32_t idleLoops;             // main loop passes within the last second
+    uint32_t maxIdleLoops;          // highest main loop passes within a second since startup (the least loaded second)
+} timerStatistics_t;
+
+
 static inline bool timer_interruptSet(void)
 {
     // if TIFR1.OCF1A is ONE an interrupt occurred
@@ -26,6 +45,11 @@ static inline void timer_interruptClear(void)
 
 
 void timer_setup(void);
+uint32_t timer_getTicks(void);
+uint32_t timer_getTimestamp(uint8_t *counts);
+uint16_t timer_getStamp(void);
+void timer_idle(void);
+void timer_getStatistics(timerStatistics_t *statistics, bool reset);
 
 
 #endif
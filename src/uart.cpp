@@ -0,0 +1,306 @@
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <util/atomic.h>
+#include "uart.hpp"
+#include "timer.hpp"
+
+
+static_assert(!(eUART_RX_BUFFER_SIZE & (eUART_RX_BUFFER_SIZE - 1)) && (eUART_RX_BUFFER_SIZE <= 256), "eUART_RX_BUFFER_SIZE has to be a power of two not larger than 256");
+static_assert(!(eUART_TX_BUFFER_SIZE & (eUART_TX_BUFFER_SIZE - 1)) && (eUART_TX_BUFFER_SIZE <= 256), "eUART_TX_BUFFER_SIZE has to be a power of two not larger than 256");
+
+
+// ring buffers, head is only written by the producer, tail only by the consumer, so no locking is necessary
+static char rxBuffer[eUART_RX_BUFFER_SIZE];
+static volatile uint8_t rxHead = 0;     // written by RX interrupt
+static volatile uint8_t rxTail = 0;     // written by main loop
+
+static char txBuffer[eUART_TX_BUFFER_SIZE];
+static volatile uint8_t txHead = 0;     // written by main loop
+static volatile uint8_t txTail = 0;     // written by UDRE interrupt
+static volatile uint8_t txEnd  = 0;     // written by main loop, UDRE interrupt sends until this index, usually it's identical to txHead except a reserved byte is on hold
+static bool txOnHold = false;           // a reserved byte hasn't been patched so far, nothing behind it can be sent
+static uint16_t txQueued = 0;           // written by main loop, bytes put into TX ring since setup
+static volatile uint16_t txSent = 0;    // written by UDRE interrupt, bytes written to UDR0 since setup
+
+// receive time stamps of line ends and frame delimiters, a ring like the RX ring (written by RX interrupt, read by main loop)
+static struct
+{
+    uint8_t  position;                  // RX ring position of the stamped byte
+    uint16_t stamp;                     // timer_getStamp() when it has been received
+} rxStamps[eUART_RX_STAMPS];
+static volatile uint8_t rxStampHead = 0;
+static volatile uint8_t rxStampTail = 0;
+static uint16_t receiveStamp;           // stamp of the byte taken last by uart_receive()
+static bool     receiveStamped;         // byte taken last has a stamp
+
+static uartStatistics_t receiveStatistics;  // written by RX interrupt
+
+
+// byte received, put it into RX ring or throw it away if ring is full (protocol will detect the missing byte via CRC)
+ISR(USART_RX_vect)
+{
+    uint8_t status = UCSR0A;        // error flags are only valid until UDR0 is read
+    char byte = UDR0;
+    if (status & ((1 << DOR0) | (1 << FE0)))
+    {
+        if ((status & (1 << DOR0)) && (receiveStatistics.overruns != 0xFFFF))
+        {
+            receiveStatistics.overruns++;
+        }
+        if ((status & (1 << FE0)) && (receiveStatistics.framingErrors != 0xFFFF))
+        {
+            receiveStatistics.framingErrors++;
+        }
+    }
+
+    uint8_t nextHead = (rxHead + 1) & (eUART_RX_BUFFER_SIZE - 1);
+    if (nextHead != rxTail)
+    {
+        uint8_t nextStampHead = (rxStampHead + 1) % eUART_RX_STAMPS;
+        if (((byte == '\n') || (byte == '\0')) && (nextStampHead != rxStampTail))
+        {
+            rxStamps[rxStampHead].position = rxHead;
+            rxStamps[rxStampHead].stamp = timer_getStamp();
+            rxStampHead = nextStampHead;
+        }
+        rxBuffer[rxHead] = byte;
+        rxHead = nextHead;
+    }
+    else if (receiveStatistics.rxOverflows != 0xFFFF)
+    {
+        receiveStatistics.rxOverflows++;
+    }
+}
+
+
+// data register empty, send next byte from TX ring or disable the interrupt if there is nothing more to send
+ISR(USART_UDRE_vect)
+{
+    uint8_t tail = txTail;
+    if (txEnd != tail)
+    {
+        UDR0 = txBuffer[tail];
+        tail = (tail + 1) & (eUART_TX_BUFFER_SIZE - 1);
+        txTail = tail;
+        txSent++;
+    }
+
+    if (txEnd == tail)
+    {
+        UCSR0B &= ~(1 << UDRIE0);
+    }
+}
+
+
+/**
+ * @brief Setup UART with 8N1 and the given baud rate, double speed mode is always used
+ *
+ * @param baudRate      baud rate to be used
+ */
+void uart_setup(uint32_t baudRate)
+{
+    noInterrupts();
+    UCSR0B = 0;
+    UCSR0A = (1 << U2X0);
+    UBRR0  = (uint16_t)((F_CPU / 4 / baudRate - 1) / 2);
+    UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+    UCSR0B = (1 << RXEN0) | (1 << TXEN0) | (1 << RXCIE0);
+    rxHead = rxTail = 0;
+    rxStampHead = rxStampTail = 0;
+    receiveStamped = false;
+    txHead = txTail = txEnd = 0;
+    txQueued = txSent = 0;
+    txOnHold = false;
+    interrupts();
+}
+
+
+/**
+ * @brief Get next received byte
+ *
+ * @param byte      received byte
+ * @return true     a byte has been taken from RX ring
+ * @return false    RX ring is empty, byte has not been changed
+ */
+bool uart_receive(char *byte)
+{
+    bool received = false;
+    uint8_t tail = rxTail;
+    if (rxHead != tail)
+    {
+        *byte = rxBuffer[tail];
+
+        // stamps are in the same order as their bytes, so only the oldest one can belong to this byte
+        uint8_t stampTail = rxStampTail;
+        receiveStamped = (stampTail != rxStampHead) && (rxStamps[stampTail].position == tail);
+        if (receiveStamped)
+        {
+            receiveStamp = rxStamps[stampTail].stamp;
+            rxStampTail = (stampTail + 1) % eUART_RX_STAMPS;
+        }
+
+        rxTail = (tail + 1) & (eUART_RX_BUFFER_SIZE - 1);
+        received = true;
+    }
+    return received;
+}
+
+
+/**
+ * @brief Get the receive time of the byte taken last by uart_receive(), only line ends and frame delimiters ('\n' and '\0') are stamped
+ *
+ * @param stamp     timer_getStamp() when the byte has been received
+ * @return true     stamp is valid
+ * @return false    byte has no stamp (not a line end or delimiter, or too many of them were waiting), stamp has not been changed
+ */
+bool uart_getReceiveStamp(uint16_t *stamp)
+{
+    if (receiveStamped)
+    {
+        *stamp = receiveStamp;
+    }
+    return receiveStamped;
+}
+
+
+/**
+ * @brief Put a byte into TX ring, if the ring is full wait until the UDRE interrupt has sent some bytes
+ * Must not be called with disabled interrupts (e.g. from any ISR) since it would block forever if TX ring is full!
+ *
+ * @param byte      byte to be sent
+ */
+void uart_transmit(char byte)
+{
+    uint8_t nextHead = (txHead + 1) & (eUART_TX_BUFFER_SIZE - 1);
+    while (nextHead == txTail)
+    {
+        // TX ring is full, UDRE interrupt will make some space
+    }
+
+    txBuffer[txHead] = byte;
+    txHead = nextHead;
+    txQueued++;
+    if (!txOnHold)
+    {
+        txEnd = nextHead;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        // clear TXC flag (by writing a ONE) so uart_transmitCompleted() will not become TRUE before this byte has been sent
+        UCSR0A = (UCSR0A & (1 << U2X0)) | (1 << TXC0);
+        UCSR0B |= (1 << UDRIE0);
+    }
+}
+
+
+/**
+ * @brief Reserve a byte in TX ring whose value is not known yet, it and all following bytes will not be sent before it has been patched
+ * Everything put into the ring while a byte is reserved has to fit into the ring, otherwise uart_transmit() will block forever!
+ *
+ * @return ring position of the reserved byte, to be given to uart_patch()
+ */
+uint8_t uart_reserve(void)
+{
+    uint8_t position = txHead;
+    txOnHold = true;
+    uart_transmit('\0');
+    return position;
+}
+
+
+/**
+ * @brief Set value of a reserved byte and release it and everything behind it for sending
+ *
+ * @param position      ring position returned by uart_reserve()
+ * @param byte          value of the reserved byte
+ */
+void uart_patch(uint8_t position, char byte)
+{
+    txBuffer[position] = byte;
+    txOnHold = false;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        txEnd = txHead;
+        UCSR0B |= (1 << UDRIE0);
+    }
+}
+
+
+/**
+ * @brief Put a string into TX ring
+ *
+ * @param string    '\0' terminated string to be sent
+ */
+void uart_print(const char *string)
+{
+    while (*string)
+    {
+        uart_transmit(*string++);
+    }
+}
+
+
+/**
+ * @brief To check if everything has been sent including the last byte's stop bit
+ *
+ * @return true     TX ring is empty and last byte has been shifted out
+ * @return false    there is still something to be sent
+ */
+bool uart_transmitCompleted(void)
+{
+    return (txHead == txTail) && (UCSR0A & (1 << TXC0));
+}
+
+
+/**
+ * @brief Get the position behind the last byte put into TX ring, to be given to uart_transmitted()
+ *
+ * @return number of bytes put into TX ring since setup (wraps around)
+ */
+uint16_t uart_transmitPosition(void)
+{
+    return txQueued;
+}
+
+
+/**
+ * @brief To check if all bytes in front of a position have left the UART including the last byte's stop bit
+ *
+ * @param position      position returned by uart_transmitPosition()
+ * @return true         everything in front of position has been sent
+ * @return false        there is still something to be sent
+ */
+bool uart_transmitted(uint16_t position)
+{
+    uint16_t sent;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        sent = txSent;
+    }
+
+    // a byte is written to UDR0 when its predecessor moves into the shift register, so the second byte behind position being written
+    // means the last byte in front of position has been shifted out completely, without further bytes TXC tells it
+    return ((int16_t)(sent - position) >= 2) || ((sent == txQueued) && uart_transmitCompleted());
+}
+
+
+/**
+ * @brief Get the receive error counters
+ *
+ * @param statistics    receive error counters
+ * @param reset         clear the counters afterwards
+ */
+void uart_getStatistics(uartStatistics_t *statistics, bool reset)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        *statistics = receiveStatistics;
+        if (reset)
+        {
+            receiveStatistics.overruns = receiveStatistics.framingErrors = receiveStatistics.rxOverflows = 0;
+        }
+    }
+}
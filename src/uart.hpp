@@ -0,0 +1,44 @@
+#if not defined UART_H
+#define UART_H
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+enum
+{
+    eUART_BAUD_RATE_DEFAULT = 9600,     // baud rate after startup (unless another one has been configured)
+    eUART_BAUD_RATE_UNIT    = 100,      // configured baud rates are given in 100 baud steps
+
+    eUART_RX_BUFFER_SIZE = 128,         // has to be a power of two
+    eUART_TX_BUFFER_SIZE = 128,         // has to be a power of two
+    eUART_RX_STAMPS      = 8,           // received line ends and frame delimiters whose receive time is kept until they are read
+};
+
+
+// receive errors, the counters saturate at 0xFFFF
+typedef struct
+{
+    uint16_t overruns;          // bytes lost because the receiver wasn't read fast enough (DOR0)
+    uint16_t framingErrors;     // bytes with an invalid stop bit (FE0), usually a baud rate mismatch or a noisy line
+    uint16_t rxOverflows;       // bytes thrown away because the RX ring was full
+} uartStatistics_t;
+
+
+void uart_setup(uint32_t baudRate);
+
+bool uart_receive(char *byte);
+bool uart_getReceiveStamp(uint16_t *stamp);
+void uart_transmit(char byte);
+void uart_print(const char *string);
+uint8_t uart_reserve(void);
+void uart_patch(uint8_t position, char byte);
+
+bool uart_transmitCompleted(void);
+uint16_t uart_transmitPosition(void);
+bool uart_transmitted(uint16_t position);
+void uart_getStatistics(uartStatistics_t *statistics, bool reset);
+
+
+#endif
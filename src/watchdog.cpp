@@ -4,21 +4,21 @@
 #include "timer.hpp"
 #include "errorAndDiagnosis.hpp"
 #include "ioHandler.hpp"
+#include "config.hpp"
+#include "history.hpp"
 
 
-// watchdog (re-)trigger time
+// watchdog (re-)trigger time is configured by eCONFIG_WATCHDOG_TIME (~ 60 seconds per default)
 #define WATCHDOG_VALUE_CLEAR 0
 enum
 {
-    eWATCHDOG_VALUE_TRIGGER = 60000 / eTICK_TIME,   // eWATCHDOG_VALUE should be ~ 60 seconds, eTICK_TIME value is given in ms units
     eWATCHDOG_VALUE_CLEAR   = WATCHDOG_VALUE_CLEAR, // value to be set in error case (also Pi can set this value, e.g. in case it panics)
 };
 
 
-// reset lock release time after error, this time has to be long enough to ensure that the external battery switch off circuit has definitely switched OFF!
+// reset lock release time after error is configured by eCONFIG_RESET_LOCK_TIME, this time has to be long enough to ensure that the external battery switch off circuit has definitely switched OFF!
 enum
 {
-    eLOCK_RESET   = 30000 / eTICK_TIME,   // when watchdog switches to error state the reset lock should be hold for several seconds (10000 = 10000ms)!
     eUNLOCK_RESET = 0,                    // reset can be unlocked again
 };
 
@@ -30,18 +30,17 @@ enum {
 };
 
 
-// timeout time during self test if expected test condition hasn't been detected
+// timeout time during self test if expected test condition hasn't been detected, the time until readback has to become 1 during initial test / become 0 during repeated test is configured by eCONFIG_TEST_TIMEOUT_TIME
 enum {
     eWATCHDOG_TEST_TIMEOUT_OVER = 0,
-    eWATCHDOG_TEST_TIMEOUT_TIME = 10U * 1000,   // time until readback has to become 1 during initial test / become 0 during repeated test
 };
 
 
-// maximum time between self test requests
-enum
+// maximum time between self test requests is configured by eCONFIG_TEST_REPEAT_TIME (in minutes), per default every 100h the output will be switched off what will be checked by monitoring the readback input
+static inline uint32_t testRepeatTime(void)
 {
-    eWATCHDOG_TEST_REPEAT_TIME = 100UL * 60 * 60 * 1000,        // every 100h the output will be switched off what will be checked by monitoring the readback input
-};
+    return (uint32_t)config_getParameter(eCONFIG_TEST_REPEAT_TIME) * 60 * 1000 / eTICK_TIME;
+}
 
 
 enum
@@ -50,7 +49,7 @@ enum
     eWATCHDOG_TESTSTATE_REPEATED_EXPECT_ON,     // repeated test is running, the repeated test checks if readback is 1, then switches of the output and waits until the readback becomes 0
     eWATCHDOG_TESTSTATE_REPEATED_EXPECT_OFF,    // repeated test is running, the repeated test checks if readback is 1, then switches of the output and waits until the readback becomes 0
 
-    eWATCHDOG_TESTSTATE_PASSED,                 // watchdog self test passed (wait until eWATCHDOG_TEST_REPEAT_TIME is over)
+    eWATCHDOG_TESTSTATE_PASSED,                 // watchdog self test passed (wait until eCONFIG_TEST_REPEAT_TIME is over)
     eWATCHDOG_TESTSTATE_FAILED,                 // repeated test failed (it's a final state and will never be left again!)
 };
 
@@ -63,6 +62,7 @@ static uint16_t resetLockCounter          = eUNLOCK_RESET;                  // i
 static bool selfTestConfirmation = false;                       // only if self test sets this to TRUE a selfTestApproval() will result in TRUE and the watchdog output is allowed to be switched ON
 
 static uint16_t watchDogTestState = eWATCHDOG_TESTSTATE_INITIAL;    // initial state after start up
+static uint32_t watchDogTestRemainingTime = 0UL;                    // remaining time until next test will be executed (initially immediately when watchdog will be switched on, repeated test after eCONFIG_TEST_REPEAT_TIME minutes)
 static bool watchDogTestRequested = false;                          // boolean to be set to true if request command has been received
 
 
@@ -101,7 +101,7 @@ static uint16_t readBackPortPolling(bool expectedReadbackState, uint8_t readback
     if (stateCounter == eSTATE_TICKS_COUNTER_END)
     {
         stateCounter = eSTATE_TICKS_COUNTER_INIT;
-        waitingTimeout = eWATCHDOG_TEST_TIMEOUT_TIME;
+        waitingTimeout = config_getParameter(eCONFIG_TEST_TIMEOUT_TIME) / eTICK_TIME;
     }
 
     // check if expectedReadbackState and readbackValue are identical (both OFF or both ON)
@@ -147,6 +147,10 @@ static void switchWatchdogIntoErrorState(void)
 {
     // stop watch dog even it's already been stopped
     noInterrupts();
+    if (watchDogState != eWATCHDOG_STATE_ERROR)
+    {
+        history_log(eHISTORY_WATCHDOG_STATE, eWATCHDOG_STATE_ERROR);
+    }
     watchDogState = eWATCHDOG_STATE_ERROR;
     watchdogCounter = eWATCHDOG_VALUE_CLEAR;
     interrupts();
@@ -191,8 +195,6 @@ bool watchdog_requestSelfTest(void)
  */
 void watchdog_selfTestHandler(uint8_t readbackValue)
 {
-    static uint32_t watchDogTestRemainingTime = 0UL;    // remaining time until next test will be executed (initially immediately when watchdog will be switched on, repeated test after eWATCHDOG_TEST_REPEAT_TIME ms)
-
     selfTestConfirmation = false;           // ensure watchdog cannot be switched ON except the following code decides that self test state is OK
 
     // execute watchdog test only if watchdog is not OFF (when watchdog is startet for the first time after startup it's frozen to zero until initial test has been finished)
@@ -215,8 +217,9 @@ void watchdog_selfTestHandler(uint8_t readbackValue)
                         // initial self test passed
                         errorAndDiagnosis_setExecutedTest(eEXECUTED_TEST_SELF_TEST);
                         selfTestConfirmation = true;            // self test confirms that watchdog output can be switched ON (test was successful)
-                        watchDogTestRemainingTime = eWATCHDOG_TEST_REPEAT_TIME;
+                        watchDogTestRemainingTime = testRepeatTime();
                         watchDogTestState = eWATCHDOG_TESTSTATE_PASSED;
+                        history_log(eHISTORY_SELF_TEST, eWATCHDOG_TESTSTATE_PASSED);      // failed tests are logged by their error
                         break;
 
                     // ignore the rest
@@ -251,12 +254,21 @@ void watchdog_selfTestHandler(uint8_t readbackValue)
             {
                 switch (ioHandler_watchdogStopAndRetrigger())
                 {
+                    case eSTOP_AND_RETRIGGER_STOPPING:
+                        // watchdog output is not triggered until readback is OFF
+                        break;
+
+                    case eSTOP_AND_RETRIGGER_RETRIGGERING:
+                        selfTestConfirmation = true;            // keep the normal trigger running in addition to the fast retrigger burst
+                        break;
+
                     case eSTOP_AND_RETRIGGER_PASSED:
                         // second stage of repeated self test passed, watchdog output could be switched OFF
                         errorAndDiagnosis_setExecutedTest(eEXECUTED_TEST_SELF_TEST);
                         selfTestConfirmation = true;                                // self test confirms that watchdog output can be switched ON (test was successful)
-                        watchDogTestRemainingTime = eWATCHDOG_TEST_REPEAT_TIME;     // reset time for next self test (100 hours)
+                        watchDogTestRemainingTime = testRepeatTime();     // reset time for next self test (100 hours per default)
                         watchDogTestState = eWATCHDOG_TESTSTATE_PASSED;             // finish test
+                        history_log(eHISTORY_SELF_TEST, eWATCHDOG_TESTSTATE_PASSED);
                         break;
 
                     case eSTOP_AND_RETRIGGER_STOP_FAILED:
@@ -343,8 +355,12 @@ void watchdog_setWatchdog(uint16_t value)
         {
             // set watch dog values
             noInterrupts();
-            watchdogCounter  = eWATCHDOG_VALUE_TRIGGER;
-            resetLockCounter = eLOCK_RESET;             // lock reset port as soon as watchdog has been started
+            watchdogCounter  = config_getParameter(eCONFIG_WATCHDOG_TIME) / eTICK_TIME;
+            resetLockCounter = config_getParameter(eCONFIG_RESET_LOCK_TIME) / eTICK_TIME;     // lock reset port as soon as watchdog has been started
+            if (watchDogState != eWATCHDOG_STATE_OK)
+            {
+                history_log(eHISTORY_WATCHDOG_STATE, eWATCHDOG_STATE_OK);
+            }
             watchDogState = eWATCHDOG_STATE_OK;
             interrupts();
             //debug_pin2(HIGH); // #1
@@ -438,6 +454,45 @@ uint8_t watchdog_getState(void)
 }
 
 
+/**
+ * @brief get remaining watchdog ticks until watchdog will switch into ERROR state if it's not triggered again
+ *
+ * @return remaining ticks, 0 if watchdog is not running
+ */
+uint16_t watchdog_getCounter(void)
+{
+    noInterrupts();
+    uint16_t counter = watchdogCounter;
+    interrupts();
+    return counter;
+}
+
+
+/**
+ * @brief get current self test state
+ *
+ * @return eWATCHDOG_TESTSTATE_INITIAL, eWATCHDOG_TESTSTATE_REPEATED_EXPECT_ON, eWATCHDOG_TESTSTATE_REPEATED_EXPECT_OFF, eWATCHDOG_TESTSTATE_PASSED or eWATCHDOG_TESTSTATE_FAILED
+ */
+uint8_t watchdog_getTestState(void)
+{
+    return watchDogTestState;
+}
+
+
+/**
+ * @brief get remaining time until next self test has to be requested
+ *
+ * @return remaining ticks
+ */
+uint32_t watchdog_getTestRemainingTime(void)
+{
+    noInterrupts();
+    uint32_t remainingTime = watchDogTestRemainingTime;
+    interrupts();
+    return remainingTime;
+}
+
+
 /**
  * @brief To check if reset port has to be locked or not
  *
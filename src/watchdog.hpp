@@ -29,6 +29,9 @@ bool watchdog_requestSelfTest(void);
 void watchdog_selfTestHandler(uint8_t readbackValue);
 
 uint8_t watchdog_getState(void);
+uint16_t watchdog_getCounter(void);
+uint8_t watchdog_getTestState(void);
+uint32_t watchdog_getTestRemainingTime(void);
 
 
 static inline bool watchdog_running(void)